@@ -0,0 +1,313 @@
+#include "BatchUnitDP.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    #define KPLINK_BATCH_UNIT_DP_AVX2
+    #include <immintrin.h>
+#endif
+
+namespace kplink {
+    const std::string BatchUnitDPParams::csv_header =
+        "algo_name,batch_width,use_simd";
+
+    std::string BatchUnitDPParams::to_csv() const {
+        return algo_name + "," +
+               std::to_string(batch_width) + "," +
+               std::to_string(use_simd);
+    }
+
+    const std::string BatchUnitDPSolution::csv_header =
+        "feasible," + UnitDPSolution::csv_header;
+
+    std::string BatchUnitDPSolution::to_csv() const {
+        return std::to_string(feasible) + "," + solution.to_csv();
+    }
+
+    namespace {
+        /** Number of lanes (doubles) of an AVX2 register. */
+        constexpr std::size_t LANES_PER_VECTOR = 4u;
+
+        /**
+         * Computes layer l >= 1 of interleaved tables with `n_lanes`
+         * lanes, from layer l-1, which starts at `previous`, and the
+         * interleaved weights of the items. For each lane, entry i of
+         * the layer is the first maximum of the entries j in the window
+         * [max(i - max_distance, l - 1), i - 1] of layer l-1, plus the
+         * weight of i, and offsets[i] is i - j. Undefined (NaN) entries
+         * are ignored: if the whole window is undefined, so is entry i.
+         * Entries i < l are not written.
+         * 
+         * Returns true iff any entry is defined.
+         */
+        bool compute_layer_lanes(std::size_t l, std::size_t n_items, std::size_t max_distance, std::size_t n_lanes,
+            const double* weights, const double* previous, double* current, std::uint16_t* offsets)
+        {
+            constexpr double MINUS_INF = -std::numeric_limits<double>::infinity();
+            bool any_defined = false;
+
+            for(auto i = l; i < n_items; ++i) {
+                const auto first_j = (i >= max_distance + l - 1u) ? i - max_distance : l - 1u;
+
+                for(std::size_t b = 0u; b < n_lanes; ++b) {
+                    double best = MINUS_INF;
+                    std::size_t best_j = i;
+
+                    // Comparisons with the undefined entries, which are NaN, are always false.
+                    for(auto j = first_j; j < i; ++j) {
+                        if(previous[j * n_lanes + b] > best) {
+                            best = previous[j * n_lanes + b];
+                            best_j = j;
+                        }
+                    }
+
+                    if(best_j == i) {
+                        current[i * n_lanes + b] = std::numeric_limits<double>::quiet_NaN();
+                        continue;
+                    }
+
+                    current[i * n_lanes + b] = best + weights[i * n_lanes + b];
+                    offsets[i * n_lanes + b] = static_cast<std::uint16_t>(i - best_j);
+                    any_defined = true;
+                }
+            }
+
+            return any_defined;
+        }
+
+        #ifdef KPLINK_BATCH_UNIT_DP_AVX2
+            /** Vectorised version of compute_layer_lanes, four lanes at a time. */
+            __attribute__((target("avx2")))
+            bool compute_layer_lanes_avx2(std::size_t l, std::size_t n_items, std::size_t max_distance, std::size_t n_lanes,
+                const double* weights, const double* previous, double* current, std::uint16_t* offsets)
+            {
+                const __m256d minus_inf = _mm256_set1_pd(-std::numeric_limits<double>::infinity());
+                const __m256d nan = _mm256_set1_pd(std::numeric_limits<double>::quiet_NaN());
+                bool any_defined = false;
+
+                for(auto i = l; i < n_items; ++i) {
+                    const auto first_j = (i >= max_distance + l - 1u) ? i - max_distance : l - 1u;
+
+                    for(std::size_t b = 0u; b < n_lanes; b += LANES_PER_VECTOR) {
+                        __m256d best = minus_inf;
+                        __m256d best_offset = _mm256_setzero_pd();
+
+                        // On ties, the earlier item is kept. Comparisons with NaN are false.
+                        for(auto j = first_j; j < i; ++j) {
+                            const __m256d w = _mm256_loadu_pd(previous + j * n_lanes + b);
+                            const __m256d better = _mm256_cmp_pd(w, best, _CMP_GT_OQ);
+
+                            best = _mm256_blendv_pd(best, w, better);
+                            best_offset = _mm256_blendv_pd(best_offset, _mm256_set1_pd(static_cast<double>(i - j)), better);
+                        }
+
+                        const __m256d defined = _mm256_cmp_pd(best, minus_inf, _CMP_GT_OQ);
+                        const __m256d weight = _mm256_add_pd(best, _mm256_loadu_pd(weights + i * n_lanes + b));
+
+                        _mm256_storeu_pd(current + i * n_lanes + b, _mm256_blendv_pd(nan, weight, defined));
+
+                        alignas(32) double lane_offsets[LANES_PER_VECTOR];
+                        _mm256_store_pd(lane_offsets, best_offset);
+
+                        for(std::size_t t = 0u; t < LANES_PER_VECTOR; ++t) {
+                            offsets[i * n_lanes + b + t] = static_cast<std::uint16_t>(lane_offsets[t]);
+                        }
+
+                        any_defined = any_defined || _mm256_movemask_pd(defined) != 0;
+                    }
+                }
+
+                return any_defined;
+            }
+        #endif
+
+        /** Whether the processor running the program supports AVX2 instructions. */
+        bool cpu_supports_avx2() {
+            #ifdef KPLINK_BATCH_UNIT_DP_AVX2
+                return __builtin_cpu_supports("avx2");
+            #else
+                return false;
+            #endif
+        }
+    }
+
+    BatchUnitDP::BatchUnitDP(const std::vector<Problem>& problems, BatchUnitDPParams params) :
+        problems{problems}, params{params}, n_lanes{0u}
+    {
+        if(problems.empty()) {
+            throw std::invalid_argument("Trying to use the Batch Unit-Profit DP without any instance.");
+        }
+
+        if(params.batch_width < 1u || params.batch_width > MAX_BATCH_WIDTH) {
+            throw std::invalid_argument("The batch width must be between 1 and " + std::to_string(MAX_BATCH_WIDTH) + ".");
+        }
+
+        n_items = problems.front().n_items;
+        max_distance = problems.front().max_distance;
+
+        for(const auto& p : problems) {
+            if(p.n_items != n_items || p.max_distance != max_distance) {
+                throw std::logic_error("Trying to use the Batch Unit-Profit DP on instances with different numbers of items or maximum distances.");
+            }
+
+            if(std::any_of(p.profits.begin(), p.profits.end(), [&] (auto pr) { return pr != 1.0; })) {
+                throw std::logic_error("Trying to use the Batch Unit-Profit DP on an instance which does not have unit profits.");
+            }
+        }
+
+        if(max_distance > std::numeric_limits<std::uint16_t>::max()) {
+            throw std::logic_error("Trying to use the Batch Unit-Profit DP with a maximum distance too large for its predecessor offsets.");
+        }
+    }
+
+    std::vector<BatchUnitDPSolution> BatchUnitDP::solve() {
+        std::vector<BatchUnitDPSolution> solutions(problems.size());
+        std::vector<std::size_t> batch;
+
+        for(std::size_t k = 0u; k < problems.size(); ++k) {
+            const auto& p = problems[k];
+
+            // Taking all items always satisfies the linking constraints.
+            if(std::accumulate(p.weights.begin(), p.weights.end(), 0.0) < p.min_weight) {
+                solutions[k] = BatchUnitDPSolution{
+                    /* .feasible = */ false,
+                    /* .solution = */ UnitDPSolution{
+                        /* .selected_items = */ {},
+                        /* .profit = */ 0.0,
+                        /* .weight = */ 0.0,
+                        /* .time_elapsed = */ 0.0
+                    }
+                };
+                continue;
+            }
+
+            batch.push_back(k);
+
+            if(batch.size() == params.batch_width) {
+                solve_batch(batch, solutions);
+                batch.clear();
+            }
+        }
+
+        if(!batch.empty()) {
+            solve_batch(batch, solutions);
+        }
+
+        return solutions;
+    }
+
+    void BatchUnitDP::solve_batch(const std::vector<std::size_t>& batch, std::vector<BatchUnitDPSolution>& solutions) {
+        using std::chrono::steady_clock;
+        using std::chrono::duration_cast;
+        using std::chrono::milliseconds;
+
+        const auto start_time = steady_clock::now();
+        [[maybe_unused]] const bool use_avx2 = params.use_simd && cpu_supports_avx2();
+        const std::size_t n_problems = batch.size();
+
+        // Padding lanes have zero weights and are never feasible.
+        n_lanes = (n_problems + LANES_PER_VECTOR - 1u) / LANES_PER_VECTOR * LANES_PER_VECTOR;
+
+        std::vector<double> weights(n_items * n_lanes, 0.0);
+
+        for(std::size_t b = 0u; b < n_problems; ++b) {
+            for(std::size_t i = 0u; i < n_items; ++i) {
+                weights[i * n_lanes + b] = problems[batch[b]].weights[i];
+            }
+        }
+
+        // Layer 0: subsets of a single item, whose predecessor offsets are never read.
+        table = weights;
+        predecessor.assign(table.size(), 0u);
+        layer_begin.assign(1u, 0u);
+
+        // Layer and item of the first feasible entry of each instance, or n_items.
+        std::vector<std::size_t> min_sz(n_problems, 0u);
+        std::vector<std::size_t> min_i(n_problems, n_items);
+        std::size_t n_unsolved = n_problems;
+
+        const auto find_feasible = [&] (std::size_t l) -> void {
+            const double* layer = table.data() + layer_offset(l);
+
+            for(std::size_t b = 0u; b < n_problems; ++b) {
+                if(min_i[b] != n_items) {
+                    continue;
+                }
+
+                // Comparisons with the undefined entries, which are NaN, are always false.
+                for(auto i = l; i < n_items; ++i) {
+                    if(layer[i * n_lanes + b] >= problems[batch[b]].min_weight) {
+                        min_sz[b] = l;
+                        min_i[b] = i;
+                        --n_unsolved;
+                        break;
+                    }
+                }
+            }
+        };
+
+        find_feasible(0u);
+
+        // Every instance is feasible, so each one is solved by layer n_items - 1.
+        for(std::size_t l = 1u; n_unsolved > 0u && l < n_items; ++l) {
+            layer_begin.push_back(layer_begin.back() + n_items - (l - 1u));
+            table.resize((layer_begin.back() + n_items - l) * n_lanes, UNDEFINED);
+            predecessor.resize(table.size());
+
+            const double* previous = table.data() + layer_offset(l - 1u);
+            double* current = table.data() + layer_offset(l);
+            std::uint16_t* offsets = predecessor.data() + layer_offset(l);
+
+            #ifdef KPLINK_BATCH_UNIT_DP_AVX2
+                const bool any_defined = use_avx2 ?
+                    compute_layer_lanes_avx2(l, n_items, max_distance, n_lanes, weights.data(), previous, current, offsets) :
+                    compute_layer_lanes(l, n_items, max_distance, n_lanes, weights.data(), previous, current, offsets);
+            #else
+                const bool any_defined = compute_layer_lanes(l, n_items, max_distance, n_lanes, weights.data(), previous, current, offsets);
+            #endif
+
+            if(!any_defined) {
+                // No subset of l+1 items, hence no larger subset, satisfies the linking constraints.
+                break;
+            }
+
+            find_feasible(l);
+        }
+
+        const auto end_time = steady_clock::now();
+        const auto time_elapsed = duration_cast<milliseconds>(end_time - start_time).count() / 1000.0;
+
+        for(std::size_t b = 0u; b < n_problems; ++b) {
+            const auto& p = problems[batch[b]];
+
+            if(min_i[b] == n_items) {
+                throw std::logic_error("Instance " + p.problem_name + " has a feasible solution, which the Batch Unit-Profit DP did not find.");
+            }
+
+            std::vector<std::size_t> selected_items = {{ min_i[b] }};
+            std::size_t current_i = min_i[b];
+            double weight = p.weights[current_i];
+
+            for(auto current_l = min_sz[b]; current_l >= 1u; --current_l) {
+                current_i -= predecessor[layer_offset(current_l) + current_i * n_lanes + b];
+                selected_items.push_back(current_i);
+                weight += p.weights[current_i];
+            }
+
+            solutions[batch[b]] = BatchUnitDPSolution{
+                /* .feasible = */ true,
+                /* .solution = */ UnitDPSolution{
+                    /* .selected_items = */ selected_items,
+                    /* .profit = */ (double) selected_items.size(),
+                    /* .weight = */ weight,
+                    /* .time_elapsed = */ time_elapsed
+                }
+            };
+        }
+    }
+}
\ No newline at end of file
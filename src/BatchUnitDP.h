@@ -0,0 +1,139 @@
+#ifndef _BATCH_UNIT_DP_H
+#define _BATCH_UNIT_DP_H
+
+#include "Problem.h"
+#include "UnitProfitDP.h"
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace kplink {
+    struct BatchUnitDPParams {
+        /** Algorithm name. */
+        std::string algo_name;
+
+        /**
+         * Number of instances solved together, in the lanes of the
+         * vectorised computation: between 1 and BatchUnitDP::MAX_BATCH_WIDTH.
+         */
+        std::size_t batch_width = 4u;
+
+        /**
+         * Use the vectorised (AVX2) computation of the layers, if the
+         * processor supports it. Otherwise, the scalar computation is used.
+         */
+        bool use_simd = true;
+
+        /** Header for csv files. */
+        static const std::string csv_header;
+
+        /** Export to comma-separated list. */
+        [[nodiscard]] std::string to_csv() const;
+    };
+
+    struct BatchUnitDPSolution {
+        /**
+         * Whether the instance is feasible, i.e., whether the weight of
+         * all its items, which always satisfy the linking constraints,
+         * reaches the minimum weight.
+         */
+        bool feasible;
+
+        /** Solution of the instance, without selected items if it is infeasible. */
+        UnitDPSolution solution;
+
+        /** Header for csv files. */
+        static const std::string csv_header;
+
+        /** Export to comma-separated list. */
+        [[nodiscard]] std::string to_csv() const;
+    };
+
+    /**
+     * Unit-profit Dynamic Programming algorithm which solves many
+     * instances with the same number of items and maximum distance,
+     * e.g., several weight vectors over the same items, together.
+     * 
+     * The instances are split in batches of params.batch_width. The
+     * tables of the instances in a batch are interleaved, so that entry
+     * W(i, l) of all instances is contiguous, and each layer is computed
+     * for all of them in lockstep: each step of the recursion over the
+     * window of predecessors handles four instances with one AVX2
+     * instruction. The batch stops at the first layer by which every
+     * instance has a feasible entry. Infeasible instances are detected
+     * beforehand and left out of the batches.
+     * 
+     * The maximum over the window is found by scanning it, in
+     * O(max_distance) per entry instead of the amortised O(1) of UnitDP,
+     * which pays off for the small distances of many small instances.
+     * The solutions are the same as those of UnitDP.
+     */
+    struct BatchUnitDP {
+        /** Largest number of instances in a batch. */
+        static constexpr std::size_t MAX_BATCH_WIDTH = 16u;
+
+        /** Problem instances, with the same number of items and maximum distance. */
+        const std::vector<Problem>& problems;
+
+        /** Algorithm parameters. */
+        const BatchUnitDPParams params;
+
+        /** Builds the algorithm object from the problem instances. */
+        BatchUnitDP(const std::vector<Problem>& problems, BatchUnitDPParams params);
+
+        /**
+         * Executes the algorithm and returns the solution of each
+         * instance, in order, whose elapsed time is that of its whole
+         * batch. The selected items are from the last to the first one.
+         */
+        [[nodiscard]] std::vector<BatchUnitDPSolution> solve();
+
+    private:
+        /** Value of the entries of the Dynamic Programming table which are not defined. */
+        static constexpr double UNDEFINED = std::numeric_limits<double>::quiet_NaN();
+
+        /** Number of items of all instances. */
+        std::size_t n_items;
+
+        /** Maximum distance of all instances. */
+        std::size_t max_distance;
+
+        /** Number of lanes of the current batch: its instances, padded to a multiple of four. */
+        std::size_t n_lanes;
+
+        /**
+         * Dynamic Programming tables of the instances of the current
+         * batch, interleaved. As in UnitDP, layer l holds the entries
+         * W(i, l) for i = l, ..., n_items-1, or ::UNDEFINED: entry W(i, l)
+         * of lane b is at position (::layer_begin[l] + i - l) * n_lanes + b.
+         */
+        std::vector<double> table;
+
+        /** Index of the first entry of each layer, counted in groups of n_lanes positions. */
+        std::vector<std::size_t> layer_begin;
+
+        /**
+         * Offsets i - j of the items j which achieve the maximum in the
+         * DP recursion for W(i, l), in the same positions as ::table.
+         */
+        std::vector<std::uint16_t> predecessor;
+
+        /**
+         * Solves the feasible instances with the given indices together,
+         * and stores their solutions at the same indices.
+         */
+        void solve_batch(const std::vector<std::size_t>& batch, std::vector<BatchUnitDPSolution>& solutions);
+
+        /**
+         * Offset from the beginning of ::table such that W(i, l) of lane
+         * b is at offset + i * n_lanes + b, for i >= l.
+         */
+        [[nodiscard]] std::size_t layer_offset(std::size_t l) const {
+            return (layer_begin[l] - l) * n_lanes;
+        }
+    };
+}
+
+#endif
\ No newline at end of file
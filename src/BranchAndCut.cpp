@@ -138,6 +138,23 @@ namespace kplink {
         std::cout << "\b\b \n";
     }
 
+    void BranchAndCut::load_incumbent(const std::vector<std::size_t>& selected_items, double lower_bound) {
+        load_initial_solution(selected_items);
+        incumbent = selected_items;
+        known_lower_bound = lower_bound;
+
+        double profit = 0.0;
+        for(const auto i : selected_items) {
+            profit += p.profits[i];
+        }
+
+        std::cout << "Info: using objective cutoff " << profit << "\n";
+
+        // Gurobi discards solutions which are not strictly better than the
+        // cutoff: relax it slightly, so that the incumbent is still accepted.
+        model.set(GRB_DoubleParam_Cutoff, profit + 1e-6 * std::max(1.0, std::abs(profit)));
+    }
+
     BranchAndCut::BranchAndCut(const Problem& p, BranchAndCutParams params) :
         p{p}, params{params}, env{}, model{env},
         x_type(p.n_items, GRB_BINARY),
@@ -219,6 +236,34 @@ namespace kplink {
             return solution;
         }
 
+        // Reports the incumbent as the best feasible solution.
+        const auto use_incumbent = [&] () -> void {
+            solution.feasible_integer_solution = true;
+            solution.primal_selected_items = *incumbent;
+            solution.primal_profit = 0.0;
+            solution.primal_weight = 0.0;
+
+            for(const auto i : *incumbent) {
+                *solution.primal_profit += p.profits[i];
+                *solution.primal_weight += p.weights[i];
+            }
+        };
+
+        if(status == GRB_CUTOFF) {
+            // No solution is better than the cutoff, which is relaxed
+            // above the incumbent's profit and is not itself a dual bound.
+            solution.best_dual_bound = known_lower_bound;
+
+            if(incumbent) {
+                // The cutoff is the incumbent's profit, which is then optimal.
+                use_incumbent();
+                solution.optimal_solution = true;
+                solution.best_dual_bound = *solution.primal_profit;
+            }
+
+            return solution;
+        }
+
         if(status == GRB_SUBOPTIMAL || status == GRB_OPTIMAL || status == GRB_TIME_LIMIT) {
             solution.feasible_integer_solution = (model.get(GRB_IntAttr_SolCount) > 0);
             solution.optimal_solution = (status == GRB_OPTIMAL);
@@ -243,9 +288,11 @@ namespace kplink {
                     }
                 }
                 delete[] x_vals_raw;
+            } else if(incumbent) {
+                use_incumbent();
             }
 
-            solution.best_dual_bound = model.get(GRB_DoubleAttr_ObjBound);
+            solution.best_dual_bound = std::max(model.get(GRB_DoubleAttr_ObjBound), known_lower_bound);
             return solution;
         }
 
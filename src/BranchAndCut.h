@@ -3,6 +3,7 @@
 
 #include <string>
 #include <optional>
+#include <limits>
 #include <gurobi_c++.h>
 #include "Problem.h"
 
@@ -123,12 +124,34 @@ namespace kplink {
         /** Name of the x variables. */
         std::vector<std::string> x_name;
 
+        /** Selected items of the incumbent loaded with load_incumbent, if any. */
+        std::optional<std::vector<std::size_t>> incumbent;
+
+        /** Lower bound on the optimal profit loaded with load_incumbent, if any. */
+        double known_lower_bound = -std::numeric_limits<double>::infinity();
+
         /** Build model for a problem. */
         BranchAndCut(const Problem& p, BranchAndCutParams params = BranchAndCutParams());
 
         /** Loads an initial solution into the model. */
         void load_initial_solution(const std::vector<std::size_t>& initial_solution);
 
+        /**
+         * Loads a known feasible solution, e.g., from an interrupted
+         * labelling, as the incumbent.
+         * 
+         * It becomes the initial solution, and its profit becomes
+         * Gurobi's objective cutoff, so that no node which cannot improve
+         * on it is explored. If Gurobi finds no better solution, the
+         * incumbent is reported as the best feasible solution.
+         * 
+         * The `lower_bound` on the optimal profit, e.g., that of the
+         * labelling's open fronts, is reported as the best dual bound
+         * if it is better than Gurobi's.
+         */
+        void load_incumbent(const std::vector<std::size_t>& selected_items,
+            double lower_bound = -std::numeric_limits<double>::infinity());
+
         /** Solves the integer programme via branch-and-cut. */
         [[nodiscard]] BranchAndCutSolutionStats solve();
 
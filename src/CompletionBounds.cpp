@@ -0,0 +1,47 @@
+#include "CompletionBounds.h"
+
+#include <cstddef>
+#include <vector>
+#include <limits>
+#include <algorithm>
+
+namespace kplink {
+    CompletionBounds::CompletionBounds(const Problem& p) :
+        p{p},
+        max_weight(p.n_items + 1u, 0.0),
+        min_ratio(p.n_items + 1u, std::numeric_limits<double>::infinity()),
+        min_next_profit(p.n_items + 1u, std::numeric_limits<double>::infinity())
+    {
+        // Suffix quantities over items j >= i, shifted by one so that
+        // entry i refers to the items following i. The entry for the
+        // empty partial solution (i == n_items) covers all items.
+        double suffix_weight = 0.0;
+        double suffix_ratio = std::numeric_limits<double>::infinity();
+
+        for(auto i = p.n_items; i > 0u; --i) {
+            max_weight[i - 1u] = suffix_weight;
+            min_ratio[i - 1u] = suffix_ratio;
+
+            suffix_weight += p.weights[i - 1u];
+
+            if(p.weights[i - 1u] > 0.0) {
+                suffix_ratio = std::min(suffix_ratio, p.profits[i - 1u] / p.weights[i - 1u]);
+            }
+        }
+
+        max_weight[p.n_items] = suffix_weight;
+        min_ratio[p.n_items] = suffix_ratio;
+
+        for(auto i = 0u; i < p.n_items; ++i) {
+            const auto limit = std::min(i + p.max_distance, p.n_items - 1u);
+
+            for(auto j = i + 1u; j <= limit; ++j) {
+                min_next_profit[i] = std::min(min_next_profit[i], p.profits[j]);
+            }
+        }
+
+        if(p.n_items > 0u) {
+            min_next_profit[p.n_items] = *std::min_element(p.profits.begin(), p.profits.end());
+        }
+    }
+}
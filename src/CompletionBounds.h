@@ -0,0 +1,80 @@
+#ifndef _COMPLETION_BOUNDS_H
+#define _COMPLETION_BOUNDS_H
+
+#include <cstddef>
+#include <limits>
+#include <vector>
+#include "Problem.h"
+
+namespace kplink {
+    /**
+     * Bounds on the ways a partial solution can be completed.
+     * 
+     * A partial solution whose highest-index item is i can only be
+     * completed by adding items i+1, ..., n_items-1, and the first
+     * item it adds must be within max_distance from i. The empty
+     * partial solution, by convention denoted by item == n_items,
+     * can be completed with any item.
+     * 
+     * All bounds are precomputed once, in O(n_items * max_distance)
+     * time, and assume that weights and profits are non-negative.
+     */
+    struct CompletionBounds {
+        /** Problem instance. */
+        const Problem& p;
+
+        /** Precomputes the bounds for a problem instance. */
+        explicit CompletionBounds(const Problem& p);
+
+        /**
+         * Maximum weight which can be added to a partial solution
+         * whose highest-index item is `item`.
+         */
+        [[nodiscard]] double max_additional_weight(std::size_t item) const {
+            return max_weight[item];
+        }
+
+        /**
+         * Lower bound on the profit needed to add at least
+         * `missing_weight` to a partial solution whose
+         * highest-index item is `item`.
+         * 
+         * It is the largest between the profit of the cheapest item
+         * which can be added next and the profit obtained by filling
+         * the missing weight with the best profit-to-weight ratio
+         * among all items which can be added.
+         */
+        [[nodiscard]] double min_additional_profit(std::size_t item, double missing_weight) const {
+            if(missing_weight <= 0.0) {
+                return 0.0;
+            }
+
+            const double ratio_bound = missing_weight * min_ratio[item];
+            return (ratio_bound > min_next_profit[item]) ? ratio_bound : min_next_profit[item];
+        }
+
+        /**
+         * Lower bound on the profit of the solutions whose first item
+         * is `item`, or infinity if no such solution is feasible.
+         */
+        [[nodiscard]] double min_profit_starting_at(std::size_t item) const {
+            if(p.weights[item] + max_weight[item] < p.min_weight) {
+                return std::numeric_limits<double>::infinity();
+            }
+
+            return p.profits[item] + min_additional_profit(item, p.min_weight - p.weights[item]);
+        }
+
+    private:
+        /** Weight of all the items following each item. */
+        std::vector<double> max_weight;
+
+        /** Lowest profit-to-weight ratio among the items following each item. */
+        std::vector<double> min_ratio;
+
+        /** Lowest profit among the items within max_distance from each item. */
+        std::vector<double> min_next_profit;
+    };
+}
+
+#endif
@@ -0,0 +1,188 @@
+#include "IntegerProfitDP.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+namespace kplink {
+    const std::string IntegerProfitDPParams::csv_header = "algo_name";
+
+    std::string IntegerProfitDPParams::to_csv() const {
+        return algo_name;
+    }
+
+    IntegerProfitDP::IntegerProfitDP(const Problem& p, IntegerProfitDPParams params) : p{p}, params{params} {
+        if(p.profit_unit <= 0.0) {
+            throw std::logic_error("Trying to use the Integer-Profit DP on an instance whose profits are not multiples of a common unit.");
+        }
+
+        item_levels.reserve(p.n_items);
+
+        for(const auto profit : p.profits) {
+            item_levels.push_back(static_cast<std::size_t>(std::llround(profit / p.profit_unit)));
+        }
+
+        distinct_levels = item_levels;
+        std::sort(distinct_levels.begin(), distinct_levels.end());
+        distinct_levels.erase(std::unique(distinct_levels.begin(), distinct_levels.end()), distinct_levels.end());
+    }
+
+    UnitDPSolution IntegerProfitDP::solve() {
+        using std::chrono::steady_clock;
+        using std::chrono::duration_cast;
+        using std::chrono::milliseconds;
+
+        const auto start_time = steady_clock::now();
+
+        table.clear();
+        predecessor.clear();
+        long_predecessor_offsets.clear();
+        windows.assign(distinct_levels.size(), std::deque<std::size_t>{});
+
+        const std::size_t max_level = distinct_levels.back();
+        std::size_t last_defined_level = 0u;
+        std::size_t c = 0u;
+        std::size_t min_i = p.n_items;
+
+        while(min_i == p.n_items) {
+            ++c;
+
+            if(compute_level(c)) {
+                last_defined_level = c;
+
+                // Comparisons with the undefined entries, which are NaN, are always false.
+                const auto begin = table.begin() + static_cast<std::ptrdiff_t>(position(0u, c));
+                const auto it = std::find_if(begin, table.end(),
+                    [&] (double w) -> bool { return w >= p.min_weight; });
+
+                min_i = static_cast<std::size_t>(std::distance(begin, it));
+            } else if(c >= last_defined_level + max_level) {
+                // Each level after c only extends the levels at most max_level
+                // before it, which are all empty, or those of single items.
+                break;
+            }
+        }
+
+        if(min_i == p.n_items) {
+            throw std::runtime_error("No feasible solution: the instance is infeasible!");
+        }
+
+        const auto items = selected_items(min_i, c);
+        double profit = 0.0;
+        double weight = 0.0;
+
+        for(const auto item : items) {
+            profit += p.profits[item];
+            weight += p.weights[item];
+        }
+
+        const auto end_time = steady_clock::now();
+        const auto time_elapsed = duration_cast<milliseconds>(end_time - start_time).count() / 1000.0;
+
+        return UnitDPSolution{
+            /* .selected_items = */ items,
+            /* .profit = */ profit,
+            /* .weight = */ weight,
+            /* .time_elapsed = */ time_elapsed
+        };
+    }
+
+    bool IntegerProfitDP::compute_level(std::size_t c) {
+        table.resize(table.size() + p.n_items, UNDEFINED);
+        predecessor.resize(table.size());
+
+        // Only the items with a profit of at most c can be in a subset of
+        // profit c. Item i extends level c - k, where k is its profit:
+        // windows[t] keeps the window of predecessors over level c - k,
+        // for k = distinct_levels[t] < c, as in UnitDP.
+        const auto n_extending = static_cast<std::size_t>(
+            std::lower_bound(distinct_levels.begin(), distinct_levels.end(), c) - distinct_levels.begin());
+        bool any_defined = false;
+
+        for(std::size_t t = 0u; t < n_extending; ++t) {
+            windows[t].clear();
+        }
+
+        for(std::size_t i = 0u; i < p.n_items; ++i) {
+            for(std::size_t t = 0u; t < n_extending; ++t) {
+                const std::size_t previous_level = c - distinct_levels[t];
+                auto& window = windows[t];
+
+                if(i >= 1u) {
+                    const double w = W(i - 1u, previous_level);
+
+                    // Items with a lower weight before i-1 can never be the maximum again.
+                    if(!std::isnan(w)) {
+                        while(!window.empty() && W(window.back(), previous_level) < w) {
+                            window.pop_back();
+                        }
+                        window.push_back(i - 1u);
+                    }
+                }
+
+                while(!window.empty() && window.front() + p.max_distance < i) {
+                    window.pop_front();
+                }
+            }
+
+            const std::size_t k = item_levels[i];
+
+            if(k == c) {
+                #ifdef DEBUG
+                    std::cout << "W(" << i << "," << c << ") = " << p.weights[i] << "\n";
+                #endif
+
+                W(i, c) = p.weights[i];
+                predecessor[position(i, c)] = FIRST_ITEM;
+                any_defined = true;
+            } else if(k < c) {
+                const auto t = static_cast<std::size_t>(
+                    std::lower_bound(distinct_levels.begin(), distinct_levels.begin() + n_extending, k) - distinct_levels.begin());
+                const auto& window = windows[t];
+
+                if(window.empty()) {
+                    // No subset of profit c - k can precede item i.
+                    continue;
+                }
+
+                const std::size_t pred = window.front();
+                const double maxW = W(pred, c - k);
+
+                #ifdef DEBUG
+                    std::cout << "W(" << i << "," << c << ") = W(" << pred << "," << (c - k) << ") + " << p.weights[i] << " = ";
+                    std::cout << (maxW + p.weights[i]) << "\n";
+                #endif
+
+                W(i, c) = maxW + p.weights[i];
+                set_P(i, c, pred);
+                any_defined = true;
+            }
+        }
+
+        return any_defined;
+    }
+
+    std::vector<std::size_t> IntegerProfitDP::selected_items(std::size_t i, std::size_t c) const {
+        std::vector<std::size_t> items = {{ i }};
+
+        while(true) {
+            const auto pos = position(i, c);
+
+            if(predecessor[pos] == FIRST_ITEM) {
+                break;
+            }
+
+            const std::size_t offset = (predecessor[pos] == LONG_OFFSET) ?
+                long_predecessor_offsets.at(pos) : predecessor[pos];
+
+            c -= item_levels[i];
+            i -= offset;
+            items.push_back(i);
+        }
+
+        return items;
+    }
+}
\ No newline at end of file
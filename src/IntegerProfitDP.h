@@ -0,0 +1,130 @@
+#ifndef _INTEGER_PROFIT_DP_H
+#define _INTEGER_PROFIT_DP_H
+
+#include "Problem.h"
+#include "UnitProfitDP.h"
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace kplink {
+    struct IntegerProfitDPParams {
+        /** Algorithm name. */
+        std::string algo_name;
+
+        /** Header for csv files. */
+        static const std::string csv_header;
+
+        /** Export to comma-separated list. */
+        [[nodiscard]] std::string to_csv() const;
+    };
+
+    /**
+     * Dynamic Programming algorithm for instances whose profits are
+     * integer multiples of Problem::profit_unit, which generalises the
+     * UnitDP from unit profits to small integer profits.
+     * 
+     * Measured in units, item i has integer profit c_i. The entry W(i, c)
+     * of the table is the highest weight of a subset of total profit c
+     * whose highest-index element is i, and it is the maximum of
+     * W(j, c - c_i) over the window of items j in [i - max_distance, i - 1],
+     * plus the weight of i (or just the weight of i, if c == c_i). The
+     * table is built one profit level c at a time, up to the first level
+     * with an entry reaching the minimum weight.
+     * 
+     * Its size is O(n_items * c*), where c* is the optimal profit in units.
+     */
+    struct IntegerProfitDP {
+        /** Problem instance. */
+        const Problem& p;
+
+        /** Algorithm parameters. */
+        const IntegerProfitDPParams params;
+
+        /** Builds the algorithm object from the problem instance. */
+        IntegerProfitDP(const Problem& p, IntegerProfitDPParams params);
+
+        /**
+         * Executes the algorithm. The selected items are from the last
+         * to the first one.
+         */
+        [[nodiscard]] UnitDPSolution solve();
+
+    private:
+        /** Value of the entries of the Dynamic Programming table which are not defined. */
+        static constexpr double UNDEFINED = std::numeric_limits<double>::quiet_NaN();
+
+        /** Stored predecessor offset meaning that the item is the first of the subset. */
+        static constexpr std::uint8_t FIRST_ITEM = 0u;
+
+        /** Stored predecessor offset meaning that the actual offset is in ::long_predecessor_offsets. */
+        static constexpr std::uint8_t LONG_OFFSET = std::numeric_limits<std::uint8_t>::max();
+
+        /** Profit of each item, in units. */
+        std::vector<std::size_t> item_levels;
+
+        /** Distinct values of ::item_levels, in increasing order. */
+        std::vector<std::size_t> distinct_levels;
+
+        /**
+         * Dynamic Programming table of weights, stored flat one profit
+         * level after the other: entry W(i, c), for c >= 1, is at
+         * position (c - 1) * n_items + i, or ::UNDEFINED.
+         */
+        std::vector<double> table;
+
+        /**
+         * Offset i - j of the predecessor j which achieves the maximum in
+         * the DP recursion for W(i, c), or ::FIRST_ITEM, as in UnitDP.
+         */
+        std::vector<std::uint8_t> predecessor;
+
+        /** Predecessor offsets which do not fit in ::predecessor, by position in the table. */
+        std::unordered_map<std::size_t, std::size_t> long_predecessor_offsets;
+
+        /**
+         * Scratch queues of compute_level, one for each of the
+         * ::distinct_levels: candidate predecessors, by decreasing weight.
+         */
+        std::vector<std::deque<std::size_t>> windows;
+
+        /**
+         * Appends profit level c to the Dynamic Programming table, whose
+         * levels 1, ..., c-1 are computed, and computes it.
+         * Returns true iff any of its entries is defined.
+         */
+        bool compute_level(std::size_t c);
+
+        /** Rebuilds the items of the subset of entry W(i, c), from the last to the first one. */
+        [[nodiscard]] std::vector<std::size_t> selected_items(std::size_t i, std::size_t c) const;
+
+        /** Position of entry (i, c) in the Dynamic Programming tables. */
+        [[nodiscard]] std::size_t position(std::size_t i, std::size_t c) const {
+            return (c - 1u) * p.n_items + i;
+        }
+
+        /** Access an element of the Dynamic Programming weights table. */
+        [[nodiscard]] double& W(std::size_t i, std::size_t c) {
+            return table[position(i, c)];
+        }
+
+        /** Sets the item which achieves the maximum in the DP recursion for W(i, c). */
+        void set_P(std::size_t i, std::size_t c, std::size_t pred) {
+            const auto pos = position(i, c);
+            const auto offset = i - pred;
+
+            if(offset >= LONG_OFFSET) {
+                predecessor[pos] = LONG_OFFSET;
+                long_predecessor_offsets[pos] = offset;
+            } else {
+                predecessor[pos] = static_cast<std::uint8_t>(offset);
+            }
+        }
+    };
+}
+
+#endif
\ No newline at end of file
@@ -1,8 +1,7 @@
 #include "Labelling.h"
+#include "GreedyHeuristic.h"
 
 #include <cstddef>
-#include <map>
-#include <set>
 #include <vector>
 #include <string>
 #include <chrono>
@@ -10,15 +9,127 @@
 #include <iterator>
 #include <cassert>
 #include <algorithm>
+#include <stdexcept>
+#include <sstream>
+#include <atomic>
+#include <thread>
+#include <functional>
+#include <utility>
 
 namespace kplink {
     const std::string LabellingParams::csv_header =
-        "algo_name,time_limit";
+        "algo_name,time_limit,use_completion_bounds,n_threads,epsilon,bidirectional,collect_stats,selection,beam_width,beam_score,label_budget";
     const std::string LabellingSolution::csv_header =
-        "n_selected_items,selected_items,profit,weight,time_elapsed,n_undominated_labels_at_sink";
+        "n_selected_items,selected_items,profit,weight,time_elapsed,n_undominated_labels_at_sink,lower_bound,gap,budget_exceeded";
+
+    std::string to_string(LabelSelection selection) {
+        switch(selection) {
+            case LabelSelection::ItemOrder: return "item_order";
+            case LabelSelection::Fifo: return "fifo";
+            case LabelSelection::BestFirst: return "best_first";
+            case LabelSelection::DepthFirst: return "depth_first";
+            case LabelSelection::AStar: return "astar";
+        }
+
+        throw std::logic_error("Unknown label selection strategy!");
+    }
+
+    LabelSelection label_selection_from_string(const std::string& name) {
+        for(const auto selection : {LabelSelection::ItemOrder, LabelSelection::Fifo, LabelSelection::BestFirst, LabelSelection::DepthFirst, LabelSelection::AStar}) {
+            if(to_string(selection) == name) {
+                return selection;
+            }
+        }
+
+        throw std::invalid_argument("Unknown label selection strategy: " + name);
+    }
+
+    std::string to_string(BeamScore score) {
+        switch(score) {
+            case BeamScore::Progress: return "progress";
+            case BeamScore::Ratio: return "ratio";
+            case BeamScore::CompletionBound: return "completion_bound";
+        }
+
+        throw std::logic_error("Unknown beam score!");
+    }
+
+    BeamScore beam_score_from_string(const std::string& name) {
+        for(const auto score : {BeamScore::Progress, BeamScore::Ratio, BeamScore::CompletionBound}) {
+            if(to_string(score) == name) {
+                return score;
+            }
+        }
+
+        throw std::invalid_argument("Unknown beam score: " + name);
+    }
+
+    void OpenLabels::push(const OpenLabel& label) {
+        labels.push_back(label);
+
+        if(selection == LabelSelection::BestFirst || selection == LabelSelection::AStar) {
+            std::push_heap(labels.begin(), labels.end(),
+                [] (const OpenLabel& l1, const OpenLabel& l2) -> bool { return l1.key > l2.key; });
+        }
+    }
+
+    OpenLabel OpenLabels::pop() {
+        assert(!labels.empty());
+
+        if(selection == LabelSelection::Fifo) {
+            const auto label = labels.front();
+            labels.pop_front();
+            return label;
+        }
+
+        if(selection == LabelSelection::BestFirst || selection == LabelSelection::AStar) {
+            std::pop_heap(labels.begin(), labels.end(),
+                [] (const OpenLabel& l1, const OpenLabel& l2) -> bool { return l1.key > l2.key; });
+        }
+
+        const auto label = labels.back();
+        labels.pop_back();
+        return label;
+    }
+
+    const std::string LabelBucketStats::csv_header =
+        "n_created,n_rejected,n_pruned,n_erased,n_alive,n_extended,peak_size,dominance_time";
+
+    LabelBucketStats& LabelBucketStats::operator+=(const LabelBucketStats& other) {
+        n_created += other.n_created;
+        n_rejected += other.n_rejected;
+        n_pruned += other.n_pruned;
+        n_erased += other.n_erased;
+        n_alive += other.n_alive;
+        n_extended += other.n_extended;
+        peak_size = std::max(peak_size, other.peak_size);
+        dominance_time += other.dominance_time;
+        return *this;
+    }
+
+    std::string LabelBucketStats::to_csv() const {
+        return std::to_string(n_created) + "," +
+               std::to_string(n_rejected) + "," +
+               std::to_string(n_pruned) + "," +
+               std::to_string(n_erased) + "," +
+               std::to_string(n_alive) + "," +
+               std::to_string(n_extended) + "," +
+               std::to_string(peak_size) + "," +
+               std::to_string(dominance_time);
+    }
 
     std::string LabellingParams::to_csv() const {
-        return algo_name + "," + std::to_string(time_limit);
+        return algo_name + "," +
+               std::to_string(time_limit) + "," +
+               std::to_string(use_completion_bounds) + "," +
+               std::to_string(n_threads) + "," +
+               std::to_string(epsilon) + "," +
+               std::to_string(bidirectional) + "," +
+               std::to_string(collect_stats) + "," +
+               to_string(selection) + "," +
+               std::to_string(beam_width) + "," +
+               to_string(beam_score) + "," +
+               std::to_string(label_budget);
     }
 
     std::string LabellingSolution::to_csv() const {
@@ -31,24 +142,10 @@ namespace kplink {
                std::to_string(profit) + "," +
                std::to_string(weight) + "," +
                std::to_string(time_elapsed) + "," +
-               std::to_string(n_undominated_labels_at_sink);
-    }
-
-    std::ostream& operator<<(std::ostream& out, const Label& label) {
-        out << "Label[ item = " << label.current_item << ", "
-            << "profit = " << label.profit << ", "
-            << "weight = " << label.weight << ", "
-            << "extended = " << std::boolalpha << label.extended << ", "
-            << "address = " << &label << ", ";
-
-        if(label.predecessor != nullptr) {
-            out << "predecessor = " << label.predecessor;
-        } else {
-            out << "no predecessor";
-        }
-
-        out << " ]";
-        return out;
+               std::to_string(n_undominated_labels_at_sink) + "," +
+               std::to_string(lower_bound) + "," +
+               std::to_string(gap) + "," +
+               std::to_string(budget_exceeded);
     }
 
     std::ostream& operator<<(std::ostream& out, const LabellingSolution& sol) {
@@ -56,7 +153,9 @@ namespace kplink {
             << "profit = " << sol.profit << ", "
             << "weight = " << sol.weight << ", "
             << "time (s) = " << sol.time_elapsed << ", "
-            << "final labels = " << sol.n_undominated_labels_at_sink << " ]\n";
+            << "final labels = " << sol.n_undominated_labels_at_sink << ", "
+            << "lower bound = " << sol.lower_bound << ", "
+            << "gap = " << sol.gap << " ]\n";
         out << "\tSelected items: ";
         std::copy(sol.selected_items.begin(), sol.selected_items.end(),
             std::ostream_iterator<std::size_t>(out, ", "));
@@ -64,166 +163,996 @@ namespace kplink {
         return out;
     }
 
+    bool LabelBucket::insert(double profit, double weight, std::size_t offset, LabelId predecessor, LabelPool& pool) {
+        // First label with weight >= the new label's weight. Because
+        // profits increase with weights, it is the one with the lowest
+        // profit among those which can dominate the new label.
+        const auto pos = static_cast<std::size_t>(
+            std::distance(weights.begin(), std::lower_bound(weights.begin(), weights.end(), weight)));
+
+        if(pos < size() && profits[pos] <= profit) {
+            return false;
+        }
+
+        // Labels dominated by the new one have weight <= its weight and
+        // profit >= its profit. They form a contiguous range ending at
+        // pos (included, if it has exactly the same weight).
+        const auto last = (pos < size() && weights[pos] == weight) ? pos + 1u : pos;
+        const auto first = static_cast<std::size_t>(
+            std::distance(profits.begin(), std::lower_bound(profits.begin(), profits.begin() + last, profit)));
+
+        #ifdef DEBUG
+            if(first < last) {
+                std::cout << "New label (" << profit << ", " << weight << ") dominates "
+                          << (last - first) << " labels: deleting them\n";
+            }
+        #endif
+
+        // The new label also represents the partial solutions of the labels it replaces.
+        double lower_bound = profit;
+
+        for(auto index = first; index < last; ++index) {
+            lower_bound = std::min(lower_bound, lower_bounds[index]);
+            pool.tombstone(ids[index]);
+        }
+
+        const auto id = pool.allocate(offset, predecessor);
+
+        if(first < last) {
+            // Overwrite the first dominated label and remove the others.
+            profits[first] = profit;
+            weights[first] = weight;
+            lower_bounds[first] = lower_bound;
+            ids[first] = id;
+
+            profits.erase(profits.begin() + first + 1u, profits.begin() + last);
+            weights.erase(weights.begin() + first + 1u, weights.begin() + last);
+            lower_bounds.erase(lower_bounds.begin() + first + 1u, lower_bounds.begin() + last);
+            ids.erase(ids.begin() + first + 1u, ids.begin() + last);
+        } else {
+            profits.insert(profits.begin() + first, profit);
+            weights.insert(weights.begin() + first, weight);
+            lower_bounds.insert(lower_bounds.begin() + first, lower_bound);
+            ids.insert(ids.begin() + first, id);
+        }
+
+        return true;
+    }
+
+    void LabelBucket::merge(const LabelBucket& new_labels, std::size_t offset, LabelPool& pool, LabelBucket& merged, double epsilon) {
+        if(new_labels.empty()) {
+            return;
+        }
+
+        merged.resize(size() + new_labels.size());
+
+        // Scan both fronts by decreasing weight. On ties, the label with
+        // the lower profit comes first and, if also the profits are the
+        // same, the existing label comes first and dominates the new one.
+        std::size_t old_index = size(), new_index = new_labels.size(), out = merged.size();
+        double best_key = std::numeric_limits<double>::infinity();
+
+        // With approximate dominance, profits are compared by their cell
+        // in the geometric grid, which is -infinity for a zero profit.
+        const bool approximate = epsilon > 0.0;
+        const double log_ratio = approximate ? std::log1p(epsilon) : 1.0;
+        const auto key = [&] (double profit) -> double {
+            return approximate ? std::floor(std::log(profit) / log_ratio) : profit;
+        };
+
+        while(old_index > 0u || new_index > 0u) {
+            const bool take_old = (new_index == 0u) || (old_index > 0u && (
+                (weights[old_index - 1u] > new_labels.weights[new_index - 1u]) ||
+                (weights[old_index - 1u] == new_labels.weights[new_index - 1u] &&
+                 profits[old_index - 1u] <= new_labels.profits[new_index - 1u])));
+
+            const LabelBucket& from = take_old ? *this : new_labels;
+            const auto index = take_old ? --old_index : --new_index;
+
+            if(key(from.profits[index]) < best_key) {
+                best_key = key(from.profits[index]);
+                --out;
+                merged.profits[out] = from.profits[index];
+                merged.weights[out] = from.weights[index];
+                merged.lower_bounds[out] = from.lower_bounds[index];
+                merged.ids[out] = take_old ? ids[index] : pool.allocate(offset, new_labels.ids[index]);
+            } else {
+                // The last label kept has at least the same weight and
+                // (almost) the same profit: it now also represents the
+                // partial solutions of the discarded label.
+                merged.lower_bounds[out] = std::min(merged.lower_bounds[out], from.lower_bounds[index]);
+
+                if(take_old) {
+                    pool.tombstone(ids[index]);
+                }
+            }
+        }
+
+        merged.profits.erase(merged.profits.begin(), merged.profits.begin() + out);
+        merged.weights.erase(merged.weights.begin(), merged.weights.begin() + out);
+        merged.lower_bounds.erase(merged.lower_bounds.begin(), merged.lower_bounds.begin() + out);
+        merged.ids.erase(merged.ids.begin(), merged.ids.begin() + out);
+
+        swap(merged);
+    }
+
     LabellingSolution Labelling::solve() {
         using std::chrono::steady_clock;
         using std::chrono::duration_cast;
         using std::chrono::milliseconds;
 
+        if(params.epsilon > 0.0 && params.selection != LabelSelection::ItemOrder) {
+            throw std::invalid_argument("Approximate dominance requires selecting labels in item order!");
+        }
+
         const auto start_time = steady_clock::now();
 
-        store_label(Label{
-            /* .current_item = */ Label::SOURCE,
-            /* .profit = */ 0.0,
-            /* .weight = */ 0.0,
-            /* .extended = */ false,
-            /* .predecessor = */ nullptr
-        });
+        initialise_incumbent();
+        shared_upper_bound = incumbent_profit;
+        shared_label_count = 0u;
+
+        const bool completed = params.bidirectional ?
+            run_bidirectional(start_time) : run_forward(start_time);
+
+        const auto end_time = steady_clock::now();
+        const auto time_elapsed = duration_cast<milliseconds>(end_time - start_time).count() / 1000.0;
+
+        // The label with the lowest profit in a sink is the first one in the bucket.
+        double best_profit = incumbent_profit;
+        std::vector<std::size_t> selected_items = incumbent_items;
+
+        for(const auto& sweep : sweeps) {
+            const auto& sink = sweep.labels_at(sweep.sink);
+
+            if(!sink.empty() && sink.profits[0u] < best_profit) {
+                best_profit = sink.profits[0u];
+                selected_items = get_items(sweep, sink.ids[0u]);
+            }
+        }
+
+        if(joined_profit < best_profit) {
+            best_profit = joined_profit;
+            selected_items = joined_items;
+        }
+
+        if(selected_items.empty()) {
+            throw std::runtime_error("No feasible solution: the instance is infeasible!");
+        }
+
+        double weight_check = 0.0;
+        double profit_check = 0.0;
+
+        for(const auto item : selected_items) {
+            weight_check += p.weights[item];
+            profit_check += p.profits[item];
+        }
+
+        double lower_bound = profit_check;
+
+        if(!completed || params.epsilon > 0.0 || params.beam_width > 0u) {
+            lower_bound = std::min(lower_bound, joined_lower_bound);
+
+            for(const auto& sweep : sweeps) {
+                lower_bound = std::min(lower_bound, sweep.get_lower_bound());
+            }
+
+            // Start items which no sweep picked up.
+            for(auto item = first_unassigned_start; item < p.n_items; ++item) {
+                lower_bound = std::min(lower_bound, bounds.min_profit_starting_at(item));
+            }
+        }
+
+        // Approximate dominance loses less than a factor (1 + epsilon) over a whole path.
+        assert(!completed || params.beam_width > 0u ||
+               lower_bound * (1.0 + params.epsilon) >= profit_check * (1.0 - 1e-9));
+
+        const double gap = (profit_check > 0.0) ? (profit_check - lower_bound) / profit_check : 0.0;
+
+        return LabellingSolution{
+            /* .selected_items = */ selected_items,
+            /* .profit = */ profit_check,
+            /* .weight = */ weight_check,
+            /* .time_elapsed = */ time_elapsed,
+            /* .n_undominated_labels_at_sink = */ count_undominated_labels_at_sink(),
+            /* .lower_bound = */ lower_bound,
+            /* .gap = */ gap,
+            /* .budget_exceeded = */ params.label_budget > 0u && shared_label_count.load() > params.label_budget,
+            /* .bucket_stats = */ collect_bucket_stats()
+        };
+    }
+
+    bool Labelling::run_forward(std::chrono::steady_clock::time_point start_time) {
+        const std::size_t n_threads = std::max<std::size_t>(params.n_threads, 1u);
+
+        // With more than one thread, use a few chunks per thread so that
+        // threads which get easier chunks can pick up more work. Fewer,
+        // larger chunks lose less dominance between different sweeps.
+        const std::size_t n_chunks = (n_threads == 1u) ?
+            1u : std::min(p.n_items, 4u * n_threads);
+        const auto chunk_start = [&] (std::size_t chunk) -> std::size_t {
+            return chunk * p.n_items / n_chunks;
+        };
+
+        std::atomic<std::size_t> next_chunk{0u};
+
+        sweeps.clear();
+        sweeps.reserve(n_threads);
+
+        for(std::size_t thread = 0u; thread < n_threads; ++thread) {
+            sweeps.emplace_back(p, params, bounds, shared_upper_bound, shared_label_count);
+        }
+
+        const auto run_sweeps = [&] (LabellingSweep& sweep) -> void {
+            while(true) {
+                const auto chunk = next_chunk.fetch_add(1u);
+
+                if(chunk >= n_chunks) {
+                    return;
+                }
+
+                if(!sweep.run(chunk_start(chunk), chunk_start(chunk + 1u), p.n_items, start_time)) {
+                    return;
+                }
+            }
+        };
+
+        if(n_threads == 1u) {
+            run_sweeps(sweeps[0u]);
+        } else {
+            std::vector<std::thread> threads;
+            threads.reserve(n_threads);
+
+            for(auto& sweep : sweeps) {
+                threads.emplace_back(run_sweeps, std::ref(sweep));
+            }
+
+            for(auto& thread : threads) {
+                thread.join();
+            }
+        }
+
+        first_unassigned_start = chunk_start(std::min(next_chunk.load(), n_chunks));
+
+        return std::all_of(sweeps.begin(), sweeps.end(),
+            [&] (const LabellingSweep& sweep) -> bool { return sweep.first_open == p.n_items; }) &&
+            first_unassigned_start == p.n_items;
+    }
+
+    bool Labelling::run_bidirectional(std::chrono::steady_clock::time_point start_time) {
+        const std::size_t split = p.n_items / 2u;
+
+        reversed_p.emplace(p.reversed());
+        reversed_bounds.emplace(*reversed_p);
+        first_unassigned_start = p.n_items;
+
+        sweeps.clear();
+        sweeps.reserve(2u);
+        sweeps.emplace_back(p, params, bounds, shared_upper_bound, shared_label_count);
+        sweeps.emplace_back(*reversed_p, params, *reversed_bounds, shared_upper_bound, shared_label_count);
+
+        // Item i of the original instance is item n_items-1-i of the
+        // reversed one: the second half of the items comes first.
+        const auto run_forward_sweep = [&] () -> void {
+            sweeps[0u].run(0u, split, split, start_time);
+        };
+        const auto run_backward_sweep = [&] () -> void {
+            sweeps[1u].run(0u, p.n_items - split, p.n_items - split, start_time);
+        };
+
+        if(params.n_threads <= 1u) {
+            run_forward_sweep();
+            run_backward_sweep();
+        } else {
+            std::thread backward_thread{run_backward_sweep};
+            run_forward_sweep();
+            backward_thread.join();
+        }
+
+        const bool completed = std::all_of(sweeps.begin(), sweeps.end(),
+            [&] (const LabellingSweep& sweep) -> bool { return sweep.first_open == p.n_items; });
+
+        // Consecutive items i < split <= j of a solution, with j - i <= max_distance.
+        const auto first_forward = (split > p.max_distance) ? split - p.max_distance : 0u;
+
+        for(auto forward_item = first_forward; forward_item < split; ++forward_item) {
+            const auto limit = std::min(forward_item + p.max_distance, p.n_items - 1u);
+
+            for(auto backward_item = split; backward_item <= limit; ++backward_item) {
+                join_fronts(forward_item, backward_item);
+            }
+        }
+
+        // If both sweeps completed, the kept buckets were joined
+        // exhaustively. Otherwise, they are needed for the lower bound.
+        if(completed) {
+            for(auto& sweep : sweeps) {
+                sweep.clear_items();
+            }
+        }
+
+        return completed;
+    }
+
+    void Labelling::join_fronts(std::size_t forward_item, std::size_t backward_item) {
+        const auto& forward = sweeps[0u].labels_at(forward_item);
+        const auto& backward = sweeps[1u].labels_at(p.n_items - 1u - backward_item);
+
+        // Labels which already collected enough weight are at the sinks
+        // and joining them would only add profit: only the lighter ones,
+        // which form a prefix of each front, are joined.
+        const auto n_forward = static_cast<std::size_t>(std::distance(forward.weights.begin(),
+            std::lower_bound(forward.weights.begin(), forward.weights.end(), p.min_weight)));
+        const auto n_backward = static_cast<std::size_t>(std::distance(backward.weights.begin(),
+            std::lower_bound(backward.weights.begin(), backward.weights.end(), p.min_weight)));
+
+        if(n_forward == 0u || n_backward == 0u) {
+            return;
+        }
+
+        join_lower_bounds.resize(n_backward + 1u);
+        join_lower_bounds[n_backward] = std::numeric_limits<double>::infinity();
+
+        for(auto index = n_backward; index > 0u; --index) {
+            join_lower_bounds[index - 1u] = std::min(join_lower_bounds[index], backward.lower_bounds[index - 1u]);
+        }
+
+        // Position of the first backward label which, together with the
+        // current forward label, collects enough weight.
+        std::size_t backward_index = n_backward;
+
+        for(std::size_t forward_index = 0u; forward_index < n_forward; ++forward_index) {
+            while(backward_index > 0u &&
+                  forward.weights[forward_index] + backward.weights[backward_index - 1u] >= p.min_weight) {
+                --backward_index;
+            }
+
+            if(backward_index == n_backward) {
+                continue;
+            }
+
+            joined_lower_bound = std::min(joined_lower_bound,
+                forward.lower_bounds[forward_index] + join_lower_bounds[backward_index]);
+
+            const double profit = forward.profits[forward_index] + backward.profits[backward_index];
+
+            if(profit < joined_profit) {
+                joined_profit = profit;
+                joined_items = get_items(sweeps[1u], backward.ids[backward_index]);
+
+                const auto forward_items = get_items(sweeps[0u], forward.ids[forward_index]);
+                joined_items.insert(joined_items.end(), forward_items.begin(), forward_items.end());
+            }
+        }
+    }
+
+    std::vector<std::size_t> Labelling::get_items(const LabellingSweep& sweep, LabelId label) const {
+        auto items = sweep.get_items(label);
+
+        if(&sweep.p != &p) {
+            // Backward labels walk back towards the end of the instance.
+            for(auto& item : items) {
+                item = p.n_items - 1u - item;
+            }
+
+            std::reverse(items.begin(), items.end());
+        }
+
+        return items;
+    }
+
+    void Labelling::initialise_incumbent() {
+        if(bounds.max_additional_weight(p.n_items) < p.min_weight) {
+            return;
+        }
+
+        // Cheapest window of consecutive items [first, last] with enough
+        // weight. For each last item, the window is shrunk from the left
+        // as long as it stays feasible.
+        std::size_t best_first = 0u, best_last = p.n_items - 1u;
+        double best_profit = std::numeric_limits<double>::infinity();
+        double window_profit = 0.0, window_weight = 0.0;
+
+        for(std::size_t first = 0u, last = 0u; last < p.n_items; ++last) {
+            window_profit += p.profits[last];
+            window_weight += p.weights[last];
+
+            while(first < last && window_weight - p.weights[first] >= p.min_weight) {
+                window_profit -= p.profits[first];
+                window_weight -= p.weights[first];
+                ++first;
+            }
+
+            if(window_weight >= p.min_weight && window_profit < best_profit) {
+                best_profit = window_profit;
+                best_first = first;
+                best_last = last;
+            }
+        }
+
+        // Recompute the window's weight and profit from scratch, as the
+        // running sums can accumulate rounding errors.
+        double weight = 0.0, profit = 0.0;
+
+        for(auto item = best_first; item <= best_last; ++item) {
+            weight += p.weights[item];
+            profit += p.profits[item];
+        }
+
+        if(weight >= p.min_weight) {
+            incumbent_profit = profit;
+            incumbent_items.clear();
+
+            for(auto item = best_last + 1u; item > best_first; --item) {
+                incumbent_items.push_back(item - 1u);
+            }
+        }
+
+        if(p.constant_profits && params.beam_width == 0u) {
+            auto greedy = GreedyHeuristic{p};
+            const auto solution = greedy.solve();
 
-        while(true) {
+            if(solution.profit < incumbent_profit) {
+                incumbent_profit = solution.profit;
+                incumbent_items = solution.selected_items;
+            }
+        }
+    }
+
+    std::vector<LabelBucketStats> Labelling::collect_bucket_stats() const {
+        std::vector<LabelBucketStats> bucket_stats(params.collect_stats ? p.n_items + 1u : 0u);
+
+        for(const auto& sweep : sweeps) {
+            for(std::size_t item = 0u; item < sweep.stats.size(); ++item) {
+                // Items of the backward sweep are numbered from the end.
+                const bool mirrored = (&sweep.p != &p) && (item < p.n_items);
+                bucket_stats[mirrored ? p.n_items - 1u - item : item] += sweep.stats[item];
+            }
+        }
+
+        return bucket_stats;
+    }
+
+    std::size_t Labelling::count_undominated_labels_at_sink() const {
+        std::vector<std::pair<double, double>> labels;
+
+        for(const auto& sweep : sweeps) {
+            const auto& sink = sweep.labels_at(sweep.sink);
+
+            for(std::size_t index = 0u; index < sink.size(); ++index) {
+                labels.emplace_back(-sink.weights[index], sink.profits[index]);
+            }
+        }
+
+        // By decreasing weight and, on ties, increasing profit: a label is
+        // undominated iff its profit is lower than all the previous ones.
+        std::sort(labels.begin(), labels.end());
+
+        std::size_t n_undominated = 0u;
+        double best_profit = std::numeric_limits<double>::infinity();
+
+        for(const auto& [weight, profit] : labels) {
+            if(profit < best_profit) {
+                best_profit = profit;
+                ++n_undominated;
+            }
+        }
+
+        return n_undominated;
+    }
+
+    bool LabellingSweep::run(std::size_t first_start, std::size_t last_start, std::size_t horizon, std::chrono::steady_clock::time_point start_time) {
+        this->first_start = first_start;
+        this->last_start = last_start;
+        this->horizon = horizon;
+        last_reached = first_start;
+
+        labels_at(source).insert(0.0, 0.0, 0u, LabelPool::NONE, pool);
+        extend_bucket(source);
+
+        const bool completed = (params.selection == LabelSelection::ItemOrder) ?
+            run_item_order(start_time) : run_label_correcting(start_time);
+
+        clear_bucket(source);
+        return completed;
+    }
+
+    bool LabellingSweep::run_item_order(std::chrono::steady_clock::time_point start_time) {
+        using std::chrono::steady_clock;
+        using std::chrono::duration_cast;
+        using std::chrono::milliseconds;
+
+        const auto& initial = labels_at(source);
+        const bool initial_open = initial.weights[0u] < p.min_weight;
+
+        for(auto item = first_start; item < horizon && (item < last_start || item <= last_reached); ++item) {
             #ifdef DEBUG
-                print_labels();
+                print_labels(item);
             #endif
 
             const auto current_time = steady_clock::now();
             const auto elapsed_time_s = duration_cast<milliseconds>(current_time - start_time).count() / 1000.0;
 
-            if(elapsed_time_s > params.time_limit) {
-                break;
+            if(elapsed_time_s > params.time_limit || exceeds_label_budget()) {
+                first_open = item;
+                first_unreached_start = item;
+                record_alive_labels(item);
+                return false;
             }
 
-            const auto current_label = get_unextended_label();
+            // The initial label reaches the start items one at a time,
+            // so that only the buckets in the window are in use.
+            if(initial_open && item < last_start) {
+                extend_front(source, 1u, item);
+            }
 
-            if(!current_label) {
-                break;
+            extend_bucket(item);
+
+            // The labels' paths are recorded in the pool: the bucket
+            // is not needed any more, unless its labels can be joined
+            // with labels beyond the horizon.
+            if(horizon == p.n_items || item + p.max_distance < horizon) {
+                clear_bucket(item);
             }
+        }
 
-            #ifdef DEBUG
-                std::cout << "Selected label for extension: " << *current_label << "\n";
-            #endif
+        record_alive_labels(p.n_items);
+        return true;
+    }
 
-            if(current_label->get().weight >= p.min_weight) {
-                extend_label(*current_label, Label::SINK);
-            } else {
-                const auto current_item = current_label->get().current_item;
-
-                if(current_item == Label::SOURCE) {
-                    for(std::size_t item = 0u; item < p.n_items; ++item) {
-                        extend_label(*current_label, item);
-                    }                
-                } else {
-                    const std::size_t limit = std::min(
-                        current_item + p.max_distance,
-                        p.n_items - 1u
-                    );
-
-                    for(std::size_t item = current_item + 1u; item <= limit; ++item) {
-                        extend_label(*current_label, item);
-                    }
+    bool LabellingSweep::run_label_correcting(std::chrono::steady_clock::time_point start_time) {
+        using std::chrono::steady_clock;
+        using std::chrono::duration_cast;
+        using std::chrono::milliseconds;
+
+        if(labels_at(source).weights[0u] < p.min_weight) {
+            for(auto item = first_start; item < last_start; ++item) {
+                extend_front(source, 1u, item);
+            }
+        }
+
+        while(!open.empty()) {
+            const auto current_time = steady_clock::now();
+            const auto elapsed_time_s = duration_cast<milliseconds>(current_time - start_time).count() / 1000.0;
+
+            if(elapsed_time_s > params.time_limit || exceeds_label_budget()) {
+                // Labels waiting to be extended are still in their
+                // buckets, which are all kept for the lower bound.
+                first_open = first_start;
+                first_unreached_start = last_start;
+                open.clear();
+                record_alive_labels(first_start);
+                return false;
+            }
+
+            const auto label = open.pop();
+
+            // Skip labels dominated while waiting, and those which can
+            // no longer improve on the upper bound since they were created.
+            if(pool.tombstones[label.id] ||
+               (params.use_completion_bounds && !can_improve(label.item, label.lower_bound, label.weight))) {
+                continue;
+            }
+
+            extend_label(label);
+
+            // Every label still waiting has a key, i.e., a lower bound on
+            // the profit of its completions, at least as high as this
+            // complete label's profit: it is optimal. The shortcut does
+            // not apply beyond a horizon, where labels can be joined.
+            if(params.selection == LabelSelection::AStar && label.weight >= p.min_weight && horizon == p.n_items) {
+                open.clear();
+            }
+        }
+
+        record_alive_labels(first_start);
+
+        for(auto item = first_start; item < horizon; ++item) {
+            if(horizon == p.n_items || item + p.max_distance < horizon) {
+                clear_bucket(item);
+            }
+        }
+
+        return true;
+    }
+
+    double LabellingSweep::get_lower_bound() const {
+        double lower_bound = std::min(upper_bound(), beam_lower_bound);
+        const auto& sink_bounds = labels_at(sink).lower_bounds;
+
+        if(!sink_bounds.empty()) {
+            lower_bound = std::min(lower_bound, *std::min_element(sink_bounds.begin(), sink_bounds.end()));
+        }
+
+        // Only the items in the window starting at the first open item,
+        // or ending at the horizon, can still hold labels.
+        const auto first_item = (first_open < p.n_items) ?
+            first_open : horizon - std::min(horizon, window - 1u);
+        const auto last_item = std::min(first_item + window, p.n_items);
+
+        // Start items which the initial label did not reach yet.
+        if(first_open < p.n_items) {
+            for(auto item = first_unreached_start; item < last_start; ++item) {
+                lower_bound = std::min(lower_bound, bounds.min_profit_starting_at(item));
+            }
+        }
+
+        for(auto item = first_item; item < last_item; ++item) {
+            const auto& bucket = labels_at(item);
+
+            for(std::size_t index = 0u; index < bucket.size(); ++index) {
+                if(bucket.weights[index] + bounds.max_additional_weight(item) < p.min_weight) {
+                    continue;
                 }
+
+                lower_bound = std::min(lower_bound,
+                    bucket.lower_bounds[index] + bounds.min_additional_profit(item, p.min_weight - bucket.weights[index]));
             }
+        }
+
+        return lower_bound;
+    }
 
-            // Using const_cast. I know that changing extended is not going
-            // to change the std::set containing the label, but std::set
-            // doesn't know, so it only returns const references from its
-            // iterators.
-            const_cast<Label&>(current_label->get()).extended = true;
+    bool LabellingSweep::exceeds_label_budget() {
+        if(params.label_budget == 0u) {
+            return false;
         }
 
-        const auto end_time = steady_clock::now();
-        const auto time_elapsed = duration_cast<milliseconds>(end_time - start_time).count() / 1000.0;
+        const std::size_t n_new_labels = pool.n_allocated - n_reported_labels;
+        n_reported_labels = pool.n_allocated;
+
+        return shared_label_count.fetch_add(n_new_labels) + n_new_labels > params.label_budget;
+    }
 
-        if(labels.find(Label::SINK) == labels.end() || labels[Label::SINK].empty()) {
-            throw std::runtime_error("No label extended up to the sink within the time limit!");
+    void LabellingSweep::publish_upper_bound() {
+        if(labels_at(sink).empty()) {
+            return;
         }
 
-        auto optimal_it = std::min_element(
-            labels[Label::SINK].begin(),
-            labels[Label::SINK].end(),
-            [] (const Label& l1, const Label& l2) -> bool {
-                return l1.profit < l2.profit;
+        const double profit = labels_at(sink).profits[0u];
+        double shared = shared_upper_bound.load();
+
+        while(profit < shared && !shared_upper_bound.compare_exchange_weak(shared, profit)) {}
+    }
+
+    std::vector<std::size_t> LabellingSweep::get_items(LabelId label) const {
+        std::vector<std::size_t> offsets;
+
+        while(label != LabelPool::NONE) {
+            offsets.push_back(pool.offset(label));
+            label = pool.predecessors[label];
+        }
+
+        // Items are recovered from the initial label onwards: the first
+        // offset is relative to position -1, just before item 0. Labels
+        // at the source and at the sink have offset 0 and add no item.
+        std::vector<std::size_t> items;
+        std::size_t position = 0u;
+
+        for(auto offset = offsets.rbegin(); offset != offsets.rend(); ++offset) {
+            if(*offset > 0u) {
+                position += *offset;
+                items.push_back(position - 1u);
             }
-        );
+        }
 
-        std::vector<std::size_t> selected_items;
-        const Label* current_label = &(*optimal_it);
-        double weight_check = 0.0;
-        double profit_check = 0.0;
+        std::reverse(items.begin(), items.end());
+        return items;
+    }
+
+    void LabellingSweep::extend_bucket(std::size_t bucket) {
+        // The bucket is final: extensions only go to higher-index items
+        // or to the sink, so its arrays are never modified meanwhile.
+        const auto& front = labels_at(bucket);
+
+        #ifdef DEBUG
+            std::cout << "Extending " << front.size() << " labels at bucket " << bucket << "\n";
+        #endif
+
+        // Labels are sorted by weight: those which already collected
+        // enough weight form a suffix of the front.
+        const auto n_open = static_cast<std::size_t>(std::distance(front.weights.begin(),
+            std::lower_bound(front.weights.begin(), front.weights.end(), p.min_weight)));
 
-        while(current_label != nullptr) {
-            const auto ci = current_label->current_item;
+        if(n_open < front.size()) {
+            candidates.clear();
+
+            for(auto index = n_open; index < front.size(); ++index) {
+                if(!params.use_completion_bounds || front.lower_bounds[index] < upper_bound()) {
+                    candidates.profits.push_back(front.profits[index]);
+                    candidates.weights.push_back(front.weights[index]);
+                    candidates.lower_bounds.push_back(front.lower_bounds[index]);
+                    candidates.ids.push_back(front.ids[index]);
+                }
+            }
 
-            if(ci != Label::SOURCE && ci != Label::SINK) {
-                selected_items.push_back(ci);
-                weight_check += p.weights[ci];
-                profit_check += p.profits[ci];
+            if(!stats.empty()) {
+                stats[p.n_items].n_pruned += front.size() - n_open - candidates.size();
             }
 
-            current_label = current_label->predecessor;
+            merge_candidates(sink, 0u);
+            publish_upper_bound();
         }
 
-        return LabellingSolution{
-            /* .selected_items = */ selected_items,
-            /* .profit = */ profit_check,
-            /* .weight = */ weight_check,
-            /* .time_elapsed = */ time_elapsed,
-            /* .n_undominated_labels_at_sink = */ labels[Label::SINK].size()
-        };
+        // The initial label is extended to the start items by run().
+        if(bucket == source) {
+            return;
+        }
+
+        if(!stats.empty()) {
+            stats[bucket].n_alive += front.size();
+            stats[bucket].n_extended += n_open;
+        }
+
+        if(n_open == 0u) {
+            return;
+        }
+
+        const std::size_t limit = std::min(
+            bucket + p.max_distance,
+            horizon - 1u
+        );
+
+        for(std::size_t destination = bucket + 1u; destination <= limit; ++destination) {
+            extend_front(bucket, n_open, destination);
+        }
     }
 
-    void Labelling::extend_label(const Label& label, std::size_t destination) {
-        auto new_label = get_extension(label, destination);
-        auto existing_labels = get_labels_at(destination);
+    void LabellingSweep::extend_front(std::size_t bucket, std::size_t n_labels, std::size_t destination) {
+        assert(destination < p.n_items);
 
+        const auto& front = labels_at(bucket);
+        const double profit = p.profits[destination];
+        const double weight = p.weights[destination];
+
+        // Shift the whole front by the destination's profit and weight.
+        // This loop over contiguous arrays has no dependencies and the
+        // compiler can vectorise it.
+        candidates.resize(n_labels);
+
+        for(std::size_t index = 0u; index < n_labels; ++index) {
+            candidates.profits[index] = front.profits[index] + profit;
+            candidates.weights[index] = front.weights[index] + weight;
+            candidates.lower_bounds[index] = front.lower_bounds[index] + profit;
+            candidates.ids[index] = front.ids[index];
+        }
+
+        merge_extension(bucket, destination);
+    }
+
+    void LabellingSweep::extend_label(const OpenLabel& label) {
         #ifdef DEBUG
-            std::cout << "Extended to new label: " << new_label << "\n";
+            std::cout << "Extending label " << label.id << " at item " << label.item << "\n";
         #endif
 
-        if(!existing_labels) {
+        if(!stats.empty()) {
+            ++stats[label.item].n_extended;
+        }
+
+        candidates.resize(1u);
+
+        if(label.weight >= p.min_weight) {
+            if(!params.use_completion_bounds || label.lower_bound < upper_bound()) {
+                candidates.profits[0u] = label.profit;
+                candidates.weights[0u] = label.weight;
+                candidates.lower_bounds[0u] = label.lower_bound;
+                candidates.ids[0u] = label.id;
+
+                merge_candidates(sink, 0u);
+                publish_upper_bound();
+            }
+
+            return;
+        }
+
+        const std::size_t limit = std::min(
+            label.item + p.max_distance,
+            horizon - 1u
+        );
+
+        for(auto destination = label.item + 1u; destination <= limit; ++destination) {
+            candidates.resize(1u);
+            candidates.profits[0u] = label.profit + p.profits[destination];
+            candidates.weights[0u] = label.weight + p.weights[destination];
+            candidates.lower_bounds[0u] = label.lower_bound + p.profits[destination];
+            candidates.ids[0u] = label.id;
+
+            merge_extension(label.item, destination);
+        }
+    }
+
+    void LabellingSweep::merge_extension(std::size_t bucket, std::size_t destination) {
+        const auto n_labels = candidates.size();
+
+        if(params.use_completion_bounds) {
+            std::size_t n_kept = 0u;
+
+            for(std::size_t index = 0u; index < n_labels; ++index) {
+                if(can_improve(destination, candidates.lower_bounds[index], candidates.weights[index])) {
+                    candidates.profits[n_kept] = candidates.profits[index];
+                    candidates.weights[n_kept] = candidates.weights[index];
+                    candidates.lower_bounds[n_kept] = candidates.lower_bounds[index];
+                    candidates.ids[n_kept] = candidates.ids[index];
+                    ++n_kept;
+                }
+            }
+
             #ifdef DEBUG
-                std::cout << "No label at destination " << destination << ": storing the new label\n";
+                std::cout << "Extension to " << destination << ": " << (n_labels - n_kept)
+                          << " new labels cannot improve on the upper bound " << upper_bound() << "\n";
             #endif
 
-            store_label(new_label);
-            return;
+            if(!stats.empty()) {
+                stats[destination].n_pruned += n_labels - n_kept;
+            }
+
+            candidates.resize(n_kept);
+        }
+
+        if(!candidates.empty()) {
+            merge_candidates(destination, (bucket == source) ? destination + 1u : destination - bucket);
+            last_reached = std::max(last_reached, destination);
         }
+    }
 
-        for(auto it = existing_labels->get().begin(); it != existing_labels->get().end();) {
-            auto& label = *it;
+    void LabellingSweep::merge_candidates(std::size_t destination, std::size_t offset) {
+        using std::chrono::steady_clock;
+        using std::chrono::duration;
 
-            if(label.dominates(new_label)) {
-                #ifdef DEBUG
-                    std::cout << "New label dominated by " << label << ": deleting new label " << new_label << "\n";
-                #endif
+        auto& bucket = labels_at(destination);
+        const auto old_size = bucket.size();
+        const auto old_n_allocated = pool.n_allocated;
 
-                return;
+        if(stats.empty()) {
+            bucket.merge(candidates, offset, pool, merged, dominance_tolerance);
+        } else {
+            const auto start_time = steady_clock::now();
+
+            bucket.merge(candidates, offset, pool, merged, dominance_tolerance);
+
+            const auto end_time = steady_clock::now();
+            stats[(destination == sink) ? p.n_items : destination].dominance_time +=
+                duration<double>(end_time - start_time).count();
+        }
+
+        if(params.beam_width > 0u && destination != sink && bucket.size() > params.beam_width) {
+            apply_beam(destination);
+        }
+
+        const auto n_created = pool.n_allocated - old_n_allocated;
+
+        // Labels created by the merge have the newest handles, as the
+        // pool does not recycle slots with label-correcting strategies.
+        if(params.selection != LabelSelection::ItemOrder && destination != sink && n_created > 0u) {
+            for(std::size_t index = 0u; index < bucket.size(); ++index) {
+                if(bucket.ids[index] >= old_n_allocated) {
+                    open.push(OpenLabel{
+                        /* .key = */ open_label_key(destination, bucket.profits[index], bucket.weights[index], bucket.lower_bounds[index]),
+                        /* .profit = */ bucket.profits[index],
+                        /* .weight = */ bucket.weights[index],
+                        /* .lower_bound = */ bucket.lower_bounds[index],
+                        /* .id = */ bucket.ids[index],
+                        /* .item = */ destination
+                    });
+                }
             }
+        }
+
+        if(stats.empty()) {
+            return;
+        }
 
-            if(new_label.dominates(label)) {
-                #ifdef DEBUG
-                    std::cout << "New label dominates " << label << ": label deleted by new label " << new_label << "\n";
-                #endif
+        auto& item_stats = stats[(destination == sink) ? p.n_items : destination];
 
-                existing_labels->get().erase(it++);
+        item_stats.n_created += n_created;
+        item_stats.n_rejected += candidates.size() - n_created;
+        item_stats.n_erased += old_size + n_created - bucket.size();
+        item_stats.peak_size = std::max(item_stats.peak_size, bucket.size());
+    }
+
+    void LabellingSweep::apply_beam(std::size_t item) {
+        auto& bucket = labels_at(item);
+
+        beam_scores.resize(bucket.size());
+        beam_order.resize(bucket.size());
+
+        for(std::size_t index = 0u; index < bucket.size(); ++index) {
+            beam_order[index] = index;
+
+            if(params.beam_score == BeamScore::Ratio) {
+                beam_scores[index] = (bucket.weights[index] > 0.0) ?
+                    bucket.profits[index] / bucket.weights[index] : std::numeric_limits<double>::infinity();
                 continue;
             }
 
-            ++it;
+            beam_scores[index] = bucket.lower_bounds[index] +
+                bounds.min_additional_profit(item, p.min_weight - bucket.weights[index]);
+
+            if(params.beam_score == BeamScore::Progress) {
+                const double progress = std::min(bucket.weights[index], p.min_weight);
+                beam_scores[index] = (progress > 0.0) ?
+                    beam_scores[index] / progress : std::numeric_limits<double>::infinity();
+            }
+        }
+
+        // Select the best labels, then restore their weight order.
+        const auto beam_end = beam_order.begin() + static_cast<std::ptrdiff_t>(params.beam_width);
+
+        std::nth_element(beam_order.begin(), beam_end - 1, beam_order.end(),
+            [&] (std::size_t i1, std::size_t i2) -> bool { return beam_scores[i1] < beam_scores[i2]; });
+
+        for(auto it = beam_end; it != beam_order.end(); ++it) {
+            if(bucket.weights[*it] + bounds.max_additional_weight(item) >= p.min_weight) {
+                beam_lower_bound = std::min(beam_lower_bound, bucket.lower_bounds[*it] +
+                    bounds.min_additional_profit(item, p.min_weight - bucket.weights[*it]));
+            }
+
+            pool.tombstone(bucket.ids[*it]);
         }
 
-        store_label(new_label);
+        std::sort(beam_order.begin(), beam_end);
+
+        for(std::size_t kept = 0u; kept < params.beam_width; ++kept) {
+            const auto index = beam_order[kept];
+
+            bucket.profits[kept] = bucket.profits[index];
+            bucket.weights[kept] = bucket.weights[index];
+            bucket.lower_bounds[kept] = bucket.lower_bounds[index];
+            bucket.ids[kept] = bucket.ids[index];
+        }
+
+        bucket.resize(params.beam_width);
     }
 
-     void Labelling::print_labels() const {
-         for(const auto& [current_item, label_set] : labels) {
-             std::cout << "=== " << label_set.size()
-                       << " labels at item " << current_item
-                       << " ===\n";
+    double LabellingSweep::open_label_key(std::size_t item, double profit, double weight, double lower_bound) const {
+        if(params.selection == LabelSelection::AStar) {
+            return lower_bound + bounds.min_additional_profit(item, p.min_weight - weight);
+        }
+
+        // Best-first: profit-to-weight ratio.
+        return (weight > 0.0) ? profit / weight : std::numeric_limits<double>::infinity();
+    }
 
-            for(const auto& label : label_set) {
-                std::cout << label << "\n";
+    void LabellingSweep::record_alive_labels(std::size_t first_item) {
+        if(stats.empty()) {
+            return;
+        }
+
+        stats[p.n_items].n_alive = labels_at(sink).size();
+
+        for(auto item = first_item; item < std::min(first_item + window, p.n_items); ++item) {
+            stats[item].n_alive += labels_at(item).size();
+        }
+    }
+
+    void LabellingSweep::print_labels(std::size_t first_item) const {
+        std::vector<std::size_t> items{source};
+
+        for(auto item = first_item; item < std::min(first_item + window, p.n_items); ++item) {
+            items.push_back(item);
+        }
+
+        items.push_back(sink);
+
+        for(const auto item : items) {
+            const auto& bucket = labels_at(item);
+
+            if(bucket.empty()) {
+                continue;
+            }
+
+            std::cout << "=== " << bucket.size()
+                      << " labels at " << ((item == source) ? "source" : (item == sink) ? "sink" : std::to_string(item))
+                      << " ===\n";
+
+            for(std::size_t index = 0u; index < bucket.size(); ++index) {
+                std::cout << "Label[ profit = " << bucket.profits[index] << ", "
+                          << "lower bound = " << bucket.lower_bounds[index] << ", "
+                          << "weight = " << bucket.weights[index] << ", "
+                          << "id = " << bucket.ids[index] << ", "
+                          << "predecessor = " << pool.predecessors[bucket.ids[index]] << " ]\n";
             }
 
             std::cout << "\n";
-         }
-     }
+        }
+    }
 }
\ No newline at end of file
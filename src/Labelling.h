@@ -1,64 +1,356 @@
 #ifndef _LABELLING_H
 #define _LABELLING_H
 
+#include <cmath>
 #include <cstddef>
+#include <cstdint>
 #include <limits>
-#include <optional>
-#include <memory>
+#include <algorithm>
+#include <stdexcept>
+#include <cassert>
+#include <atomic>
+#include <chrono>
+#include <deque>
 #include <iostream>
+#include <optional>
+#include <string>
+#include <unordered_map>
 #include <vector>
-#include <map>
-#include <set>
-#include <cassert>
 
 #include "Problem.h"
+#include "CompletionBounds.h"
 
 namespace kplink {
-    struct Label {
-        static constexpr std::size_t SOURCE = std::numeric_limits<std::size_t>::max() - 2u;
-        static constexpr std::size_t SINK = std::numeric_limits<std::size_t>::max() - 1u;
+    /** Compact handle identifying a label in a LabelPool. */
+    using LabelId = std::uint32_t;
 
-        /** Current item. */
-        std::size_t current_item;
+    /**
+     * Arena recording the path information of the labels.
+     * 
+     * Each label created during the algorithm gets a slot in the
+     * arena, which stores the handle of its predecessor label and
+     * the offset between its item and its predecessor's. Slots are
+     * never moved, so handles stay valid as long as the label is
+     * referenced, and allocating a label takes a slot from the free
+     * list or appends one at the end of the arena.
+     * 
+     * The initial label is considered to reside before item 0: a
+     * label at item i extended from it has offset i+1. Labels at the
+     * sink have offset 0, as they add no item. All other offsets are
+     * at most max_distance, so they are stored in a single byte per
+     * label, and the rare offsets which do not fit are kept in a side
+     * table.
+     * 
+     * When a label is dominated and removed from its bucket, its slot
+     * is tombstoned rather than released at once: labels which were
+     * already extended from it can still walk back through it when the
+     * solution is reconstructed. Each slot counts its references, i.e.,
+     * its bucket, until the label is removed from it, and the labels
+     * extended from it. A slot without references is freed, which in
+     * turn releases its predecessor, so that the arena only holds the
+     * labels in the buckets and their ancestors. Without ::recycle,
+     * slots are never freed and handles are allocated in increasing
+     * order.
+     */
+    struct LabelPool {
+        /** Handle used for labels without predecessor. */
+        static constexpr LabelId NONE = std::numeric_limits<LabelId>::max();
 
-        /** Profit collected in the current partial solution. */
-        double profit;
+        /** Stored offset meaning that the actual offset is in ::long_offsets. */
+        static constexpr std::uint8_t LONG_OFFSET = std::numeric_limits<std::uint8_t>::max();
 
-        /** Weight collected in the current partial solution. */
-        double weight;
+        /** Offset of the item of each label from the item of its predecessor. */
+        std::vector<std::uint8_t> offsets;
+
+        /** Offsets which do not fit in ::offsets, by label. */
+        std::unordered_map<LabelId, std::size_t> long_offsets;
+
+        /** Predecessor of each label (NONE for the initial label). */
+        std::vector<LabelId> predecessors;
+
+        /** Whether each label was removed from its bucket. */
+        std::vector<bool> tombstones;
+
+        /** Number of references to each label: its bucket, while it is in it, and its successors. */
+        std::vector<std::uint32_t> n_references;
+
+        /** Slots of the freed labels, which are reused first. */
+        std::vector<LabelId> free_slots;
+
+        /** Number of labels ever allocated. */
+        std::size_t n_allocated = 0u;
+
+        /** Whether the slots of labels without references are freed and reused. */
+        bool recycle;
+
+        /** Builds an empty arena. */
+        explicit LabelPool(bool recycle = true) : recycle{recycle} {}
+
+        /** Number of slots in the arena, including the free ones. */
+        [[nodiscard]] std::size_t size() const { return offsets.size(); }
+
+        /** Allocates a new label, referenced by its bucket, and returns its handle. */
+        LabelId allocate(std::size_t offset, LabelId predecessor) {
+            LabelId id;
+
+            if(!free_slots.empty()) {
+                id = free_slots.back();
+                free_slots.pop_back();
+            } else {
+                if(size() >= NONE) {
+                    throw std::overflow_error("Too many labels: the label pool is exhausted!");
+                }
+
+                id = static_cast<LabelId>(size());
+                offsets.push_back(0u);
+                predecessors.push_back(NONE);
+                tombstones.push_back(false);
+                n_references.push_back(0u);
+            }
+
+            if(offset >= LONG_OFFSET) {
+                offsets[id] = LONG_OFFSET;
+                long_offsets.emplace(id, offset);
+            } else {
+                offsets[id] = static_cast<std::uint8_t>(offset);
+            }
+
+            predecessors[id] = predecessor;
+            tombstones[id] = false;
+            n_references[id] = 1u;
 
-        /** True if the label was already extended. */
-        bool extended = false;
+            if(predecessor != NONE) {
+                ++n_references[predecessor];
+            }
+
+            ++n_allocated;
+            return id;
+        }
+
+        /** Offset of the item of a label from the item of its predecessor. */
+        [[nodiscard]] std::size_t offset(LabelId label) const {
+            assert(label < size());
+            return (offsets[label] == LONG_OFFSET) ? long_offsets.at(label) : offsets[label];
+        }
 
-        /** Predecessor label. */
-        const Label *const predecessor;
+        /** Marks a label as removed from its bucket. */
+        void tombstone(LabelId label) {
+            assert(label < size());
+            tombstones[label] = true;
+            release(label);
+        }
 
         /**
-         * Whether this label dominates another one.
-         * 
-         * Dominance is not strict, i.e., L1 dominates L2 if
-         *  L1::current_item == L2::current_item AND
-         *  L1::profit <= L2::profit AND
-         *  L1::weight >= L2::weight
-         * and there is no need to enforce any or at least one
-         * of the two inequalities to be strict.
+         * Drops the reference of its bucket to a label, e.g., once the
+         * bucket was extended. The label, and then its ancestors, are
+         * freed when no reference to them is left.
          */
-        bool dominates(const Label& other) const {
-            return (current_item == other.current_item) &&
-                   (profit <= other.profit) &&
-                   (weight >= other.weight);
+        void release(LabelId label) {
+            while(recycle && label != NONE) {
+                assert(n_references[label] > 0u);
+
+                if(--n_references[label] > 0u) {
+                    return;
+                }
+
+                if(offsets[label] == LONG_OFFSET) {
+                    long_offsets.erase(label);
+                }
+
+                free_slots.push_back(label);
+                label = predecessors[label];
+            }
         }
+    };
+
+    /**
+     * Pareto front of the labels residing at one item.
+     * 
+     * Each label is a partial solution whose highest-index item is
+     * the bucket's item, and is described by the profit and weight
+     * it collected and by its handle in the LabelPool, which records
+     * its predecessor. The attributes of the labels are stored in
+     * separate contiguous arrays, all indexed by the position of the
+     * label in the bucket.
+     * 
+     * Label L1 dominates label L2 in the same bucket if
+     *  L1.profit <= L2.profit AND L1.weight >= L2.weight.
+     * Dominance is not strict, i.e., there is no need to enforce
+     * any or at least one of the two inequalities to be strict.
+     * 
+     * The bucket only ever holds mutually non-dominated labels,
+     * sorted by increasing weight. Therefore, profits are also
+     * sorted increasingly and the label with the lowest profit is
+     * always the first one.
+     */
+    struct LabelBucket {
+        /** Profits collected by the labels. */
+        std::vector<double> profits;
+
+        /** Weights collected by the labels. */
+        std::vector<double> weights;
+
+        /**
+         * Lower bounds on the profit of the partial solutions which
+         * each label represents.
+         * 
+         * With exact dominance, this is the label's profit. When
+         * approximate dominance discards a label, the label which
+         * dominates it also represents its partial solutions, and
+         * its lower bound is lowered to the discarded one's.
+         */
+        std::vector<double> lower_bounds;
+
+        /** Handles of the labels in the pool. */
+        std::vector<LabelId> ids;
+
+        /** Number of labels in the bucket. */
+        [[nodiscard]] std::size_t size() const { return profits.size(); }
+
+        /** Whether the bucket holds no label. */
+        [[nodiscard]] bool empty() const { return profits.empty(); }
+
+        /**
+         * Inserts a new label in the bucket.
+         * 
+         * If a label in the bucket dominates the new one, the new
+         * label is discarded. Otherwise, it is allocated in the pool
+         * with the given offset from its predecessor, inserted at its
+         * position in the weight order, and all labels it dominates
+         * are removed and tombstoned. Both checks are binary searches:
+         * the only label which can dominate the new one is the first
+         * one with a weight not lower than the new label's, and the
+         * labels dominated by the new one form a contiguous range
+         * right before it.
+         * 
+         * Returns true iff the new label was inserted.
+         */
+        bool insert(double profit, double weight, std::size_t offset, LabelId predecessor, LabelPool& pool);
 
         /**
-         * Operator required to store Label in std::set.
+         * Merges a front of new labels into the bucket.
+         * 
+         * The new labels must be sorted by increasing weight and
+         * must not dominate each other, and all come from the same
+         * bucket. Their ::ids are the handles of their predecessors:
+         * new labels which survive the merge are allocated in the pool
+         * with the given offset, while existing labels which are
+         * dominated are tombstoned.
+         * 
+         * Both fronts are scanned once, by decreasing weight, and
+         * a label is kept iff its profit is strictly lower than that
+         * of all labels with higher weight. The merged front is built
+         * in the scratch bucket `merged`, which is then swapped with
+         * this bucket, so that no memory is allocated in the long run.
+         * 
+         * With a positive `epsilon`, dominance is approximate: profits
+         * are rounded down to the geometric grid of ratio (1 + epsilon)
+         * anchored at 1, and a label is also discarded when a label with
+         * at least the same weight lies in the same or a lower cell of
+         * the grid. As the grid is fixed, a label which absorbed others
+         * and is later absorbed itself passes them to a label in a cell
+         * no higher than theirs: however many merges the bucket goes
+         * through, each label it discards is represented by a label
+         * whose profit is less than (1 + epsilon) times its own.
          */
-        bool operator<(const Label& other) const {
-            return std::make_tuple(current_item, profit, weight) <
-                   std::make_tuple(other.current_item, other.profit, other.weight);
+        void merge(const LabelBucket& new_labels, std::size_t offset, LabelPool& pool, LabelBucket& merged, double epsilon = 0.0);
+
+        /** Removes all labels from the bucket, keeping its memory. */
+        void clear() {
+            profits.clear();
+            weights.clear();
+            lower_bounds.clear();
+            ids.clear();
+        }
+
+        /** Resizes the arrays of the bucket. */
+        void resize(std::size_t size) {
+            profits.resize(size);
+            weights.resize(size);
+            lower_bounds.resize(size);
+            ids.resize(size);
+        }
+
+        /** Swaps the contents of two buckets. */
+        void swap(LabelBucket& other) {
+            profits.swap(other.profits);
+            weights.swap(other.weights);
+            lower_bounds.swap(other.lower_bounds);
+            ids.swap(other.ids);
         }
     };
 
-    std::ostream& operator<<(std::ostream& out, const Label& label);
+    /** Order in which labels are picked for extension. */
+    enum class LabelSelection {
+        /**
+         * Sweep the items in increasing order, extending all labels
+         * of an item at once. Each bucket is extended exactly once,
+         * when no more labels can reach it.
+         */
+        ItemOrder,
+
+        /** Extend labels one at a time, in the order they were created. */
+        Fifo,
+
+        /**
+         * Extend labels one at a time, starting from the one with the
+         * lowest profit-to-weight ratio. It tends to produce labels at
+         * the sink early, which is useful when the time limit is tight.
+         */
+        BestFirst,
+
+        /**
+         * Extend labels one at a time, starting from the last one
+         * created. It quickly reaches the sink, giving an early upper
+         * bound to prune with.
+         */
+        DepthFirst,
+
+        /**
+         * Extend labels one at a time, starting from the one with the
+         * lowest lower bound on the profit of its completions, i.e.,
+         * its profit plus the CompletionBounds estimate of the profit
+         * still needed to reach the minimum weight. The estimate never
+         * exceeds the actual profit needed, so the first label with
+         * enough weight to be extended is optimal and the search stops.
+         */
+        AStar
+    };
+
+    /** Name of a label selection strategy, as used on the command line and in csv files. */
+    [[nodiscard]] std::string to_string(LabelSelection selection);
+
+    /** Parses the name of a label selection strategy. Throws std::invalid_argument if unknown. */
+    [[nodiscard]] LabelSelection label_selection_from_string(const std::string& name);
+
+    /** Score ranking the labels of a bucket in beam search: lowest first. */
+    enum class BeamScore {
+        /**
+         * Progress towards the minimum weight: the completion bound of
+         * the label (see BeamScore::CompletionBound) divided by the
+         * weight it collected, capped at the minimum weight. Unlike the
+         * completion bound alone, whose estimate of the missing profit
+         * is optimistic, and the profit-to-weight ratio, it does not
+         * favour fresh, light labels over long partial paths.
+         */
+        Progress,
+
+        /** Profit-to-weight ratio of the label. */
+        Ratio,
+
+        /**
+         * Lower bound on the profit of the label's completions: its
+         * profit plus the CompletionBounds estimate of the profit still
+         * needed to reach the minimum weight.
+         */
+        CompletionBound
+    };
+
+    /** Name of a beam score, as used on the command line and in csv files. */
+    [[nodiscard]] std::string to_string(BeamScore score);
+
+    /** Parses the name of a beam score. Throws std::invalid_argument if unknown. */
+    [[nodiscard]] BeamScore beam_score_from_string(const std::string& name);
 
     struct LabellingParams {
         /** Algorithm name. */
@@ -67,6 +359,144 @@ namespace kplink {
         /** Time limit in seconds. */
         double time_limit = 3600.0;
 
+        /**
+         * Prune labels using completion bounds.
+         * 
+         * A label is discarded when it cannot collect the minimum
+         * weight with the items following its own, or when its
+         * profit plus a lower bound on the profit needed to reach
+         * the minimum weight is not better than the incumbent.
+         */
+        bool use_completion_bounds = true;
+
+        /** Number of threads running sweeps in parallel. */
+        std::size_t n_threads = 1u;
+
+        /**
+         * Relative tolerance of approximate dominance.
+         * 
+         * With a positive value, dominance is approximate: the labels
+         * of each bucket are compared on a geometric grid of profits of
+         * ratio (1 + epsilon)^(1 / (n_items + 1)), as in an FPTAS (see
+         * LabelBucket::merge), so each bucket loses less than this
+         * factor. A path crosses at most n_items + 1 buckets, i.e., its
+         * items and the sink, so its error is less than (1 + epsilon).
+         * Weights are never approximated, so the solution is always
+         * feasible, and the certified LabellingSolution::lower_bound
+         * satisfies
+         *  lower_bound >= profit / (1 + epsilon),
+         * unless the run stops early because of the time limit, the
+         * label budget or the beam.
+         * 
+         * Zero gives the exact algorithm.
+         */
+        double epsilon = 0.0;
+
+        /**
+         * Run a bidirectional labelling which meets in the middle.
+         * 
+         * Forward labels are grown over the first half of the items
+         * and backward labels over the second half, and the labels
+         * at the two sides of the split item are joined. Each sweep
+         * only explores paths within its half, which keeps the fronts
+         * small on long instances. It uses at most two threads, one
+         * per direction.
+         */
+        bool bidirectional = false;
+
+        /**
+         * Collect statistics on the labels of each item, which are
+         * returned in LabellingSolution::bucket_stats.
+         */
+        bool collect_stats = false;
+
+        /**
+         * Order in which labels are extended.
+         * 
+         * All strategies other than LabelSelection::ItemOrder are
+         * label-correcting: a label can be extended before its bucket
+         * is final, and extended again if a better label arrives. They
+         * require exact dominance, i.e., a zero ::epsilon.
+         */
+        LabelSelection selection = LabelSelection::ItemOrder;
+
+        /**
+         * Maximum number of labels kept in each item's bucket, or zero
+         * for no limit.
+         * 
+         * With a limit k, the algorithm becomes a beam search: after
+         * each merge, only the k labels with the best ::beam_score are
+         * kept, so each bucket is extended in O(max_distance * k) time
+         * and the whole algorithm runs in O(n_items * max_distance * k)
+         * time. The solution is only heuristic, but the completion
+         * bounds of the labels cut by the beam still give a valid
+         * LabellingSolution::lower_bound.
+         */
+        std::size_t beam_width = 0u;
+
+        /** Score used to choose the labels kept by the beam. */
+        BeamScore beam_score = BeamScore::Progress;
+
+        /**
+         * Maximum number of labels which all sweeps together can
+         * create, or zero for no limit.
+         * 
+         * The path information of a label is only freed once no label
+         * in a bucket descends from it, and never with label-correcting
+         * strategies, so this caps the memory used by the algorithm.
+         * When the budget is exceeded, the sweeps stop as if the time
+         * limit was reached, and LabellingSolution::budget_exceeded is set.
+         */
+        std::size_t label_budget = 0u;
+
+        /** Header for csv files. */
+        static const std::string csv_header;
+
+        /** Export to comma-separated list. */
+        [[nodiscard]] std::string to_csv() const;
+    };
+
+    /**
+     * Statistics on the lifecycle of the labels residing at one item
+     * (or at the sink).
+     * 
+     * Every label which reaches the item is either pruned by the
+     * completion bounds, rejected because it is dominated on arrival,
+     * or created. Created labels are either erased later by a new
+     * label which dominates them, or alive in the final front of the
+     * item, which is then extended.
+     */
+    struct LabelBucketStats {
+        /** Labels created at the item. */
+        std::size_t n_created = 0u;
+
+        /** New labels discarded because a label at the item dominated them. */
+        std::size_t n_rejected = 0u;
+
+        /** New labels discarded because they could not improve on the upper bound. */
+        std::size_t n_pruned = 0u;
+
+        /** Labels erased because a newer label dominated them, or cut by the beam. */
+        std::size_t n_erased = 0u;
+
+        /**
+         * Labels in the final front of the item, i.e., when it was
+         * extended or, if it never was, at the end of the run.
+         */
+        std::size_t n_alive = 0u;
+
+        /** Labels extended to the following items. */
+        std::size_t n_extended = 0u;
+
+        /** Largest number of labels at the item at the same time. */
+        std::size_t peak_size = 0u;
+
+        /** Time spent in dominance checks, in seconds. */
+        double dominance_time = 0.0;
+
+        /** Accumulates the statistics of another sweep at the same item. */
+        LabelBucketStats& operator+=(const LabelBucketStats& other);
+
         /** Header for csv files. */
         static const std::string csv_header;
 
@@ -90,6 +520,31 @@ namespace kplink {
         /** Number of undominated labels at the sink. */
         std::size_t n_undominated_labels_at_sink;
 
+        /**
+         * Lower bound on the optimal profit.
+         * 
+         * It is equal to the profit if the exact algorithm terminated
+         * within the time limit, proving optimality. With approximate
+         * dominance, it certifies how far the profit is from optimal.
+         */
+        double lower_bound;
+
+        /** Relative gap between the profit and the lower bound. */
+        double gap;
+
+        /**
+         * Whether the algorithm stopped because it created more than
+         * LabellingParams::label_budget labels. In this case, the
+         * solution is only heuristic, but ::lower_bound is valid.
+         */
+        bool budget_exceeded;
+
+        /**
+         * Statistics on the labels of each item, followed by those of
+         * the sink. Empty unless LabellingParams::collect_stats is set.
+         */
+        std::vector<LabelBucketStats> bucket_stats;
+
         /** Header for csv files. */
         static const std::string csv_header;
 
@@ -99,125 +554,546 @@ namespace kplink {
 
     std::ostream& operator<<(std::ostream& out, const LabellingSolution& sol);
 
-    struct Labelling {
+    /** Label waiting to be extended by a label-correcting algorithm. */
+    struct OpenLabel {
+        /** Priority of the label, for best-first and A* selection: lowest first. */
+        double key;
+
+        /** Profit collected by the label. */
+        double profit;
+
+        /** Weight collected by the label. */
+        double weight;
+
+        /** Lower bound on the profit of the partial solutions it represents. */
+        double lower_bound;
+
+        /** Handle of the label in the pool. */
+        LabelId id;
+
+        /** Item where the label resides. */
+        std::size_t item;
+    };
+
+    /**
+     * Labels waiting to be extended, ordered according to a selection
+     * strategy.
+     * 
+     * Each strategy uses its own structure: a queue for first-in,
+     * first-out selection, a stack for depth-first selection and a
+     * binary heap keyed by OpenLabel::key for best-first and A* selection,
+     * so that picking the next label never requires a rescan. Labels
+     * which are dominated while waiting are not removed: they are
+     * skipped when picked, as their handle is tombstoned.
+     */
+    struct OpenLabels {
+        /** Selection strategy. */
+        LabelSelection selection;
+
+        /** Waiting labels, as a queue, a stack or a heap. */
+        std::deque<OpenLabel> labels;
+
+        /** Builds an empty collection for the given strategy. */
+        explicit OpenLabels(LabelSelection selection) : selection{selection} {}
+
+        /** Whether no label is waiting. */
+        [[nodiscard]] bool empty() const { return labels.empty(); }
+
+        /** Adds a waiting label. */
+        void push(const OpenLabel& label);
+
+        /** Removes and returns the next label to extend. */
+        OpenLabel pop();
+
+        /** Removes all waiting labels. */
+        void clear() { labels.clear(); }
+    };
+
+    /**
+     * State of a forward sweep of the labelling algorithm.
+     * 
+     * A sweep only considers solutions whose first item lies in a
+     * given range of start items. Different sweeps can run in
+     * parallel: each one owns its buckets and its label pool, and
+     * they only share the upper bound used for pruning.
+     */
+    struct LabellingSweep {
         /** Problem instance. */
         const Problem& p;
 
         /** Labelling algorithm parameters. */
-        const LabellingParams params;
+        const LabellingParams& params;
 
-        /** Builds the algorithm object from the problem instance. */
-        Labelling(const Problem& p, const LabellingParams params) : p{p}, params{params} {}
+        /** Bounds used to prune labels which cannot lead to an improving solution. */
+        const CompletionBounds& bounds;
 
-        /** Executes the labelling algorithm. */
-        [[nodiscard]] LabellingSolution solve();
+        /**
+         * Upper bound on the optimal profit, shared among all sweeps.
+         * 
+         * It is initialised with the profit of the incumbent and each
+         * sweep lowers it when it finds a better label at its sink.
+         */
+        std::atomic<double>& shared_upper_bound;
+
+        /** Number of labels created by all sweeps, as last reported by each of them. */
+        std::atomic<std::size_t>& shared_label_count;
+
+        /** Item index denoting the bucket holding the initial, empty label. */
+        const std::size_t source;
+
+        /** Item index denoting the bucket holding the complete labels. */
+        const std::size_t sink;
+
+        /**
+         * Number of consecutive items whose buckets can hold labels
+         * at the same time.
+         * 
+         * When the bucket of item i is extended, labels can only
+         * reside at items i, ..., i+max_distance: the buckets of
+         * earlier items were already extended and emptied, and later
+         * items are out of reach. Label-correcting selection strategies
+         * can extend labels at any item, and use one bucket per item.
+         */
+        const std::size_t window;
+
+        /**
+         * Tolerance of approximate dominance in each bucket, such that
+         * (1 + dominance_tolerance)^(n_items + 1) = 1 + params.epsilon.
+         */
+        const double dominance_tolerance;
 
         /**
          * Data structure used to hold the labels.
          * 
-         * It maps the resident item to a set of labels which
-         * have that item as their ::current_item.
+         * The buckets of the items form a ring buffer of ::window
+         * entries, where item i uses entry i % window. The two extra
+         * buckets at the end hold, respectively, the initial empty
+         * label and the labels which collected enough weight to form
+         * a feasible solution. Therefore, the memory used by the
+         * labels being extended does not grow with the number of
+         * items, and only the compact path information in ::pool
+         * is kept for the labels already extended.
          */
-        using Labels = std::map<std::size_t, std::set<Label>>;
+        using Labels = std::vector<LabelBucket>;
 
         /** Collection of all labels. */
-        Labels labels;
+        Labels buckets;
 
-    private:
         /**
-         * Extendes a label to a new item.
-         * 
-         * It assumes that the extension is feasible:
-         * this should be checked before calling this
-         * function.
+         * Path information of the labels of this sweep and of their
+         * ancestors. Label-correcting selection strategies keep waiting
+         * labels outside the buckets and do not recycle its slots.
+         */
+        LabelPool pool;
+
+        /**
+         * First bucket which was not extended, if the sweep was
+         * interrupted by the time limit. Equal to p.n_items otherwise.
+         */
+        std::size_t first_open;
+
+        /**
+         * Statistics on the labels of each item, followed by those of
+         * the sink. Empty unless params.collect_stats is set.
          */
-        Label get_extension(const Label& label, std::size_t destination) const {
-            assert(destination == Label::SINK || destination < p.n_items);
+        std::vector<LabelBucketStats> stats;
 
-            const double new_profit =
-                (destination == Label::SINK) ? label.profit : label.profit + p.profits[destination];
+        /** Builds an empty sweep. */
+        LabellingSweep(const Problem& p, const LabellingParams& params, const CompletionBounds& bounds, std::atomic<double>& shared_upper_bound, std::atomic<std::size_t>& shared_label_count) :
+            p{p}, params{params}, bounds{bounds}, shared_upper_bound{shared_upper_bound}, shared_label_count{shared_label_count},
+            source{p.n_items}, sink{p.n_items + 1u}, window{(params.selection == LabelSelection::ItemOrder) ? std::min(p.max_distance, p.n_items) + 1u : p.n_items + 1u},
+            dominance_tolerance{std::pow(1.0 + params.epsilon, 1.0 / static_cast<double>(p.n_items + 1u)) - 1.0},
+            buckets(window + 2u), pool{params.selection == LabelSelection::ItemOrder}, first_open{p.n_items}, stats(params.collect_stats ? p.n_items + 1u : 0u),
+            horizon{p.n_items}, open{params.selection} {}
+
+        /** Bucket holding the labels residing at an item, at the ::source or at the ::sink. */
+        [[nodiscard]] LabelBucket& labels_at(std::size_t item) {
+            return buckets[slot(item)];
+        }
+
+        /** Bucket holding the labels residing at an item, at the ::source or at the ::sink. */
+        [[nodiscard]] const LabelBucket& labels_at(std::size_t item) const {
+            return buckets[slot(item)];
+        }
+
+        /** Empties the buckets of all items, keeping the labels at the sink. */
+        void clear_items() {
+            for(std::size_t entry = 0u; entry < window; ++entry) {
+                for(const auto id : buckets[entry].ids) {
+                    pool.release(id);
+                }
+
+                buckets[entry].clear();
+            }
+        }
 
-            const double new_weight =
-                (destination == Label::SINK) ? label.weight : label.weight + p.weights[destination];
+        /** Empties the bucket of an item or of the ::source, releasing its labels in the pool. */
+        void clear_bucket(std::size_t item) {
+            auto& bucket = labels_at(item);
 
-            const bool extended =
-                (destination == Label::SINK) ? true : false;
+            for(const auto id : bucket.ids) {
+                pool.release(id);
+            }
 
-            return Label{
-                /* .current_item = */ destination,
-                /* .profit = */ new_profit,
-                /* .weight = */ new_weight,
-                /* .extended = */ extended,
-                /* .predecessor = */ &label
-            };
+            bucket.clear();
         }
 
         /**
-         * Stores a label in the collection of all labels.
+         * Runs the sweep for all solutions whose first item is in the
+         * range [first_start, last_start) and whose items all precede
+         * `horizon`.
+         * 
+         * Labels at the sink are kept between runs, while all other
+         * buckets are emptied as soon as they are extended. When the
+         * horizon is before the last item, the buckets of the items
+         * within max_distance from the horizon are kept instead, as
+         * their labels can be joined with labels beyond the horizon.
+         * With a label-correcting selection strategy, the buckets are
+         * only emptied at the end of the run, as labels which arrive
+         * later must still be checked for dominance against them.
          * 
-         * If this is the first label with the given current vertex,
-         * it creates the corresponding entry in the map.
+         * Returns false iff the sweep was interrupted because the
+         * time limit, counted from `start_time`, or the label budget
+         * was exceeded.
          */
-        void store_label(Label label) {
-            if(labels.find(label.current_item) != labels.end()) {
-                labels[label.current_item].insert(std::move(label));
-            } else {
-                labels[label.current_item] = { std::move(label) };
+        bool run(std::size_t first_start, std::size_t last_start, std::size_t horizon, std::chrono::steady_clock::time_point start_time);
+
+        /**
+         * Best upper bound on the optimal profit: the lowest between
+         * the shared upper bound and the profit of the labels at the sink.
+         */
+        [[nodiscard]] double upper_bound() const {
+            const double shared = shared_upper_bound.load(std::memory_order_relaxed);
+
+            const auto& complete = labels_at(sink);
+
+            if(complete.empty() || complete.profits[0u] >= shared) {
+                return shared;
             }
+            return complete.profits[0u];
         }
 
         /**
-         * Gets the set of labels residing at a node/item, if any.
+         * Whether a label residing at the given bucket, with the given
+         * profit and weight, can still be extended to a solution which
+         * is feasible and strictly better than the upper bound.
          * 
-         * If no labels are yet at the item, it returns nullopt.
+         * With approximate dominance, the label's lower bound must be
+         * passed as its profit, so that none of the partial solutions
+         * it represents is wrongly discarded.
          */
-        std::optional<std::reference_wrapper<std::set<Label>>> get_labels_at(std::size_t item) {
-            if(labels.find(item) != labels.end()) {
-                return std::ref(labels[item]);
-            } else {
-                return std::nullopt;
+        [[nodiscard]] bool can_improve(std::size_t bucket, double profit, double weight) const {
+            if(weight + bounds.max_additional_weight(bucket) < p.min_weight) {
+                return false;
             }
+
+            return profit + bounds.min_additional_profit(bucket, p.min_weight - weight) < upper_bound();
         }
 
         /**
-         * Gets an unexteded label, if any.
+         * Lower bound on the optimal profit of the solutions explored
+         * by the sweep.
          * 
-         * If there are unextended labels, it returns a reference
-         * to one of them.
-         * Otherwise, it returns std::nullopt.
+         * Any such solution better than the upper bound must extend
+         * one of the labels still in the buckets of the items, i.e.,
+         * those not extended yet or kept at the horizon, or start at
+         * an item which the initial label did not reach yet. Therefore,
+         * the lowest among the upper bound and the completion bounds
+         * of those labels and start items is a valid lower bound. With
+         * a beam, solutions can also extend a label cut by the beam.
+         */
+        [[nodiscard]] double get_lower_bound() const;
+
+        /** Gets the items in the partial solution corresponding to a label. */
+        [[nodiscard]] std::vector<std::size_t> get_items(LabelId label) const;
+
+    private:
+        /** One past the last item which labels can reach in the current run. */
+        std::size_t horizon;
+
+        /** Labels waiting to be extended, with a label-correcting selection strategy. */
+        OpenLabels open;
+
+        /** First start item which the initial label did not reach, if the run was interrupted. */
+        std::size_t first_unreached_start;
+
+        /** First start item of the current run. */
+        std::size_t first_start;
+
+        /** One past the last start item of the current run. */
+        std::size_t last_start;
+
+        /** Highest-index bucket which received labels in the current run. */
+        std::size_t last_reached;
+
+        /** Scratch bucket holding the labels being extended to a destination. */
+        LabelBucket candidates;
+
+        /** Scratch bucket where the merged front of a destination is built. */
+        LabelBucket merged;
+
+        /** Scratch array of apply_beam: positions of the labels in the bucket, by score. */
+        std::vector<std::size_t> beam_order;
+
+        /** Scratch array of apply_beam: scores of the labels in the bucket. */
+        std::vector<double> beam_scores;
+
+        /** Lowest completion bound among the labels cut by the beam. */
+        double beam_lower_bound = std::numeric_limits<double>::infinity();
+
+        /** Number of labels of ::pool already added to the shared label count. */
+        std::size_t n_reported_labels = 0u;
+
+        /** Runs the sweep extending the buckets in item order. */
+        bool run_item_order(std::chrono::steady_clock::time_point start_time);
+
+        /**
+         * Runs the sweep extending one label at a time, in the order
+         * given by the selection strategy, until no label is waiting.
+         */
+        bool run_label_correcting(std::chrono::steady_clock::time_point start_time);
+
+        /**
+         * Extends a single label: to the sink if it collected enough
+         * weight, and to the items following its own otherwise.
+         */
+        void extend_label(const OpenLabel& label);
+
+        /**
+         * Extends all labels residing in a bucket.
+         * 
+         * Labels whose weight already reaches the minimum weight
+         * are extended to the sink. All others are extended to
+         * the items following the current one, up to max_distance
+         * positions away and before the horizon. The initial label
+         * at the source is instead extended by run(), to each start
+         * item right before that item's bucket, so that only the
+         * buckets in the window are ever in use.
          * 
-         * For the moment we search for labels in whatever
-         * arbitrary order they are returned by the iterators
-         * over the map and the sets which form its values.
+         * Because labels only ever move forward, once all buckets
+         * of lower-index items have been extended, no new label
+         * can reach the current item: its bucket is final and it
+         * is extended exactly once.
          */
-        std::optional<std::reference_wrapper<const Label>> get_unextended_label() const {
-            for(const auto& [current_item, label_set] : labels) {
-                for(const auto& label : label_set) {
-                    if(!label.extended) {
-                        return std::ref(label);
-                    }
-                }
+        void extend_bucket(std::size_t bucket);
+
+        /**
+         * Extends the first `n_labels` labels of a bucket to a new
+         * destination bucket, all at once.
+         * 
+         * It assumes that the extension is feasible, i.e., that the
+         * destination is either the sink or an item within
+         * max_distance from the bucket's item.
+         * 
+         * Extending to an item adds the same profit and weight to
+         * every label, so the extended labels still form a Pareto
+         * front sorted by weight. They are computed with a single
+         * pass over the contiguous arrays of the bucket, filtered
+         * with the completion bounds (when used) and merged into the
+         * destination's front with LabelBucket::merge.
+         */
+        void extend_front(std::size_t bucket, std::size_t n_labels, std::size_t destination);
+
+        /**
+         * Prunes the ::candidates, which were extended from a bucket
+         * to a destination item, with the completion bounds (when
+         * used) and merges those left into the destination's front.
+         */
+        void merge_extension(std::size_t bucket, std::size_t destination);
+
+        /**
+         * Merges the ::candidates, which were extended with the given
+         * offset, into the bucket of a destination item or of the sink.
+         * 
+         * It also updates the destination's statistics, if collected,
+         * and, with a label-correcting selection strategy, adds the
+         * labels created at an item to the waiting labels.
+         */
+        void merge_candidates(std::size_t destination, std::size_t offset);
+
+        /**
+         * Keeps only the params.beam_width labels with the best score
+         * in the bucket of an item, still sorted by weight. The labels
+         * cut are tombstoned and their completion bounds are recorded
+         * in ::beam_lower_bound.
+         */
+        void apply_beam(std::size_t item);
+
+        /** Priority of a label waiting to be extended, for best-first and A* selection. */
+        [[nodiscard]] double open_label_key(std::size_t item, double profit, double weight, double lower_bound) const;
+
+        /**
+         * Records the labels at the sink, and those still in the
+         * buckets of the items from `first_item`, as alive.
+         */
+        void record_alive_labels(std::size_t first_item);
+
+        /** Lowers the shared upper bound to the best profit at the sink, if better. */
+        void publish_upper_bound();
+
+        /**
+         * Adds the labels created since the last call to the shared
+         * label count, and returns true iff all sweeps together
+         * created more than params.label_budget labels.
+         */
+        [[nodiscard]] bool exceeds_label_budget();
+
+        /** Index in ::buckets of the bucket of an item, of the ::source or of the ::sink. */
+        [[nodiscard]] std::size_t slot(std::size_t item) const {
+            if(item == source) {
+                return window;
+            } else if(item == sink) {
+                return window + 1u;
             }
-            return std::nullopt;
+
+            assert(item < p.n_items);
+            return item % window;
         }
 
         /**
-         * Extends a label to a new destination item.
+         * Prints the labels at the source, at the sink and at the
+         * items in the window starting at `first_item` to stdout.
+         */
+        void print_labels(std::size_t first_item) const;
+    };
+
+    struct Labelling {
+        /** Problem instance. */
+        const Problem& p;
+
+        /** Labelling algorithm parameters. */
+        const LabellingParams params;
+
+        /** Bounds used to prune labels which cannot lead to an improving solution. */
+        const CompletionBounds bounds;
+
+        /** Builds the algorithm object from the problem instance. */
+        Labelling(const Problem& p, const LabellingParams params) :
+            p{p}, params{params}, bounds{p} {}
+
+        /**
+         * Executes the labelling algorithm.
+         * 
+         * The start items are split into chunks, which are handed out
+         * to params.n_threads threads from a shared queue: each thread
+         * picks the next chunk as soon as it is done with the previous
+         * one, and runs an independent LabellingSweep for it. At the
+         * end, the best label among all sweeps' sinks is returned.
+         * 
+         * With params.bidirectional, a forward and a backward sweep
+         * are run instead, and the best joined pair of labels is also
+         * considered.
+         */
+        [[nodiscard]] LabellingSolution solve();
+
+        /**
+         * Sweeps run by each thread. In the bidirectional algorithm,
+         * the forward sweep and the backward sweep, which works on
+         * the reversed instance.
+         */
+        std::vector<LabellingSweep> sweeps;
+
+        /** Profit of the best solution joining a forward and a backward label. */
+        double joined_profit = std::numeric_limits<double>::infinity();
+
+        /** Items of the best solution joining a forward and a backward label. */
+        std::vector<std::size_t> joined_items;
+
+        /**
+         * Lower bound on the profit of the solutions joining a forward
+         * and a backward label. It differs from ::joined_profit only
+         * with approximate dominance.
+         */
+        double joined_lower_bound = std::numeric_limits<double>::infinity();
+
+        /** Profit of the best solution known before running the labelling. */
+        double incumbent_profit = std::numeric_limits<double>::infinity();
+
+        /** Items of the best solution known before running the labelling. */
+        std::vector<std::size_t> incumbent_items;
+
+    private:
+        /** Upper bound on the optimal profit, shared among all sweeps. */
+        std::atomic<double> shared_upper_bound;
+
+        /** Number of labels created by all sweeps, checked against params.label_budget. */
+        std::atomic<std::size_t> shared_label_count;
+
+        /** Start items which were never handed out to a sweep. */
+        std::size_t first_unassigned_start;
+
+        /** Mirror instance explored by the backward sweep of the bidirectional algorithm. */
+        std::optional<Problem> reversed_p;
+
+        /** Completion bounds of the mirror instance. */
+        std::optional<CompletionBounds> reversed_bounds;
+
+        /**
+         * Runs forward sweeps over chunks of start items.
          * 
-         * It assumes that the extension is feasible.
+         * Returns true iff all sweeps completed within the time limit.
+         */
+        bool run_forward(std::chrono::steady_clock::time_point start_time);
+
+        /**
+         * Runs the bidirectional algorithm.
+         * 
+         * The items are split at item m = n_items/2. The forward sweep
+         * explores the solutions within items 0, ..., m-1 and the
+         * backward sweep, on the reversed instance, those within items
+         * m, ..., n_items-1. Any other solution contains two consecutive
+         * items i < m <= j, with j - i <= max_distance, and it is the
+         * union of a forward label at i and a backward label at j: all
+         * such pairs are joined with join_fronts.
+         * 
+         * Returns true iff both sweeps completed within the time limit.
+         */
+        bool run_bidirectional(std::chrono::steady_clock::time_point start_time);
+
+        /**
+         * Joins the labels of a forward bucket with those of a
+         * backward bucket, updating the best joined solution.
          * 
-         * It creates the new extended label and performs the
-         * following checks:
-         *  - If there is any label at the destination which
-         *    dominates the new extension, then it "kills" the
-         *    extension immediately.
-         *  - If the new extension dominates any label at the
-         *    destination, it removes the dominated label.
+         * Both fronts are sorted by weight and the cheapest backward
+         * label which completes a forward label is the first one with
+         * enough weight. As forward labels get heavier, this label
+         * moves towards lighter ones: the join is a single two-pointer
+         * scan of the fronts.
+         */
+        void join_fronts(std::size_t forward_item, std::size_t backward_item);
+
+        /**
+         * Scratch array of join_fronts: lowest lower bound among the
+         * backward labels with at least a given position in the front.
          */
-        void extend_label(const Label& label, std::size_t destination);
+        std::vector<double> join_lower_bounds;
 
-        /** Prints all the labels to stdout. */
-        void print_labels() const;
+        /** Items of a label of a sweep, in the numbering of the original instance. */
+        [[nodiscard]] std::vector<std::size_t> get_items(const LabellingSweep& sweep, LabelId label) const;
+
+        /**
+         * Computes an initial incumbent solution.
+         * 
+         * The incumbent is the cheapest set of consecutive items
+         * with enough weight, found with a two-pointer scan of the
+         * items. For instances with constant profits, it is replaced
+         * by the solution of the GreedyHeuristic if this is better,
+         * unless the labelling is a beam search: the greedy rescans
+         * all items for each item it selects, which takes longer than
+         * the beam itself.
+         * 
+         * If the instance is infeasible, the incumbent stays empty.
+         */
+        void initialise_incumbent();
+
+        /** Sums the statistics of all sweeps, if collected. */
+        [[nodiscard]] std::vector<LabelBucketStats> collect_bucket_stats() const;
+
+        /**
+         * Number of labels at the sinks of all sweeps which are not
+         * dominated by a label at the sink of another sweep.
+         */
+        [[nodiscard]] std::size_t count_undominated_labels_at_sink() const;
     };
 }
 
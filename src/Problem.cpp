@@ -5,18 +5,49 @@
 #include <cstdlib>
 #include <iostream>
 #include <string>
+#include <algorithm>
+#include <cmath>
 #include <json.hpp>
 
 namespace kplink {
     const std::string Problem::csv_header =
-        "problem_name,problem_n_items,problem_max_distance,problem_min_weight,problem_constant_profits";
+        "problem_name,problem_n_items,problem_max_distance,problem_min_weight,problem_constant_profits,problem_profit_unit";
 
     std::string Problem::to_csv() const {
         return problem_name + "," +
                std::to_string(n_items) + "," +
                std::to_string(max_distance) + "," +
                std::to_string(min_weight) + "," +
-               std::to_string(constant_profits);
+               std::to_string(constant_profits) + "," +
+               std::to_string(profit_unit);
+    }
+
+    namespace {
+        /** Largest value of which all profits are integer multiples, as in Problem::profit_unit. */
+        double find_profit_unit(const std::vector<double>& profits) {
+            const auto min_profit = *std::min_element(profits.begin(), profits.end());
+
+            if(!(min_profit > 0.0)) {
+                return 0.0;
+            }
+
+            const auto is_multiple = [] (double profit, double unit) -> bool {
+                const auto ratio = profit / unit;
+                return std::abs(ratio - std::round(ratio)) <= 1e-9 * std::max(ratio, 1.0);
+            };
+
+            // The unit divides the smallest profit, so it is min_profit / q
+            // for an integer q, and the largest unit has the smallest q.
+            for(std::size_t q = 1u; q <= Problem::MAX_PROFIT_DIVISOR; ++q) {
+                const auto unit = min_profit / static_cast<double>(q);
+
+                if(std::all_of(profits.begin(), profits.end(), [&] (double profit) { return is_multiple(profit, unit); })) {
+                    return unit;
+                }
+            }
+
+            return 0.0;
+        }
     }
 
     Problem::Problem(std::filesystem::path problem_file) :
@@ -45,13 +76,25 @@ namespace kplink {
         const auto first_profit = profits.at(0u);
         const auto equal = [] (double x, double y) { return std::abs(x - y) < 1e-12; };
         constant_profits = std::all_of(profits.begin(), profits.end(), [&] (double profit) { return equal(profit, first_profit); });
+        profit_unit = find_profit_unit(profits);
+    }
+
+    Problem Problem::reversed() const {
+        auto mirror = *this;
+
+        mirror.problem_name += "_reversed";
+        std::reverse(mirror.weights.begin(), mirror.weights.end());
+        std::reverse(mirror.profits.begin(), mirror.profits.end());
+
+        return mirror;
     }
 
     std::ostream& operator<<(std::ostream& out, const Problem& problem) {
         out << "Problem[ n_items = " << problem.n_items << ", "
             << "max_distance = " << problem.max_distance << ", "
             << "min_weight = " << problem.min_weight << ", "
-            << "constant_profits = " << std::boolalpha << problem.constant_profits << " ]";
+            << "constant_profits = " << std::boolalpha << problem.constant_profits << ", "
+            << "profit_unit = " << problem.profit_unit << " ]";
         return out;
     }
 }
\ No newline at end of file
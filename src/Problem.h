@@ -40,6 +40,20 @@ namespace kplink {
         /** True if all profits are constant. */
         bool constant_profits;
 
+        /**
+         * Largest positive value of which all profits are integer
+         * multiples, up to a small tolerance, or zero if there is none.
+         * 
+         * It is looked for among the fractions min_profit / q, for
+         * q = 1, ..., MAX_PROFIT_DIVISOR: e.g., profits 1 and 0.1 give
+         * 0.1, and profits 0.2 and 0.3 give 0.1. The instance can then
+         * be solved with the IntegerProfitDP.
+         */
+        double profit_unit;
+
+        /** Largest ratio between the smallest profit and ::profit_unit. */
+        static constexpr std::size_t MAX_PROFIT_DIVISOR = 1000u;
+
         /** Header for csv files. */
         static const std::string csv_header;
 
@@ -48,6 +62,14 @@ namespace kplink {
 
         /** Read problem from json file. */
         explicit Problem(std::filesystem::path problem_file);
+
+        /**
+         * Mirror instance, in which item i becomes item n_items-1-i.
+         * 
+         * Compactness is symmetric, so the two instances have the
+         * same feasible solutions, up to the renumbering of items.
+         */
+        [[nodiscard]] Problem reversed() const;
     };
 
     std::ostream& operator<<(std::ostream& out, const Problem& problem);
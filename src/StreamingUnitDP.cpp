@@ -0,0 +1,214 @@
+#include "StreamingUnitDP.h"
+#include "GreedyHeuristic.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+
+namespace kplink {
+    const std::string StreamingUnitDPParams::csv_header =
+        "algo_name,max_items";
+
+    std::string StreamingUnitDPParams::to_csv() const {
+        return algo_name + "," +
+               std::to_string(max_items);
+    }
+
+    StreamingUnitDP::StreamingUnitDP(double min_weight, std::size_t max_distance, StreamingUnitDPParams params) :
+        min_weight{min_weight}, max_distance{max_distance}, params{params},
+        start_time{std::chrono::steady_clock::now()},
+        n_layers{(params.max_items > 0u) ? params.max_items : std::numeric_limits<std::size_t>::max()},
+        columns(max_distance + 1u), column_paths(max_distance + 1u) {}
+
+    std::size_t StreamingUnitDP::greedy_max_items(const Problem& p) {
+        const double total_weight = std::accumulate(p.weights.begin(), p.weights.end(), 0.0);
+        const double max_weight = *std::max_element(p.weights.begin(), p.weights.end());
+
+        // The greedy heuristic would not terminate on an infeasible instance.
+        if(total_weight < p.min_weight || (p.max_distance == 0u && max_weight < p.min_weight)) {
+            return p.n_items;
+        }
+
+        auto greedy = GreedyHeuristic{p};
+        return greedy.solve().selected_items.size();
+    }
+
+    void StreamingUnitDP::push(double weight) {
+        const std::size_t i = n_items++;
+        auto& column = columns[slot(i)];
+        auto& paths = column_paths[slot(i)];
+
+        // The column is reused from item i - max_distance - 1, which
+        // cannot precede any item from i on.
+        for(const auto node : paths) {
+            release_node(node);
+        }
+
+        const std::size_t n_entries = std::min(i + 1u, n_layers);
+
+        column.assign(n_entries, UNDEFINED);
+        paths.assign(n_entries, NONE);
+
+        if(n_entries == 0u) {
+            // A single item is enough for a feasible solution.
+            return;
+        }
+
+        column[0u] = weight;
+        paths[0u] = create_node(i, NONE);
+
+        if(windows.size() + 1u < n_entries) {
+            windows.resize(n_entries - 1u);
+        }
+
+        const std::size_t window_start = (i > max_distance) ? i - max_distance : 0u;
+
+        for(std::size_t l = 1u; l < n_entries; ++l) {
+            // Candidate predecessors of item i, i.e., those in the window
+            // [i - max_distance, i - 1] with a defined W(j, l - 1). Their
+            // weights are non-increasing from front to back, and equal
+            // weights are in item order, so the front is the first maximum.
+            auto& window = windows[l - 1u];
+            const auto W_previous = [&] (std::size_t j) -> double { return columns[slot(j)][l - 1u]; };
+
+            while(!window.empty() && window.front() < window_start) {
+                window.pop_front();
+            }
+
+            // Item i - 1 enters the window. Items with a lower weight
+            // before it can never be the maximum again.
+            if(const double w = W_previous(i - 1u); !std::isnan(w)) {
+                while(!window.empty() && W_previous(window.back()) < w) {
+                    window.pop_back();
+                }
+                window.push_back(i - 1u);
+            }
+
+            if(window.empty()) {
+                // No subset of l items can precede item i.
+                continue;
+            }
+
+            const std::size_t pred = window.front();
+
+            column[l] = W_previous(pred) + weight;
+            paths[l] = create_node(i, column_paths[slot(pred)][l - 1u]);
+        }
+
+        // Comparisons with the undefined entries, which are NaN, are always false.
+        const auto feasible = std::find_if(column.begin(), column.end(),
+            [&] (double w) -> bool { return w >= min_weight; });
+
+        if(feasible == column.end()) {
+            return;
+        }
+
+        const auto l = static_cast<std::size_t>(std::distance(column.begin(), feasible));
+
+        ++nodes[paths[l]].n_references;
+        release_node(best_path);
+        best_path = paths[l];
+        best_weight = column[l];
+
+        drop_layers(l);
+    }
+
+    UnitDPSolution StreamingUnitDP::finish() const {
+        using std::chrono::steady_clock;
+        using std::chrono::duration_cast;
+        using std::chrono::milliseconds;
+
+        if(best_path == NONE) {
+            throw std::runtime_error("No feasible solution: the instance is infeasible!");
+        }
+
+        std::vector<std::size_t> selected_items;
+
+        for(auto node = best_path; node != NONE; node = nodes[node].predecessor) {
+            selected_items.push_back(nodes[node].item);
+        }
+
+        const auto end_time = steady_clock::now();
+        const auto time_elapsed = duration_cast<milliseconds>(end_time - start_time).count() / 1000.0;
+
+        return UnitDPSolution{
+            /* .selected_items = */ selected_items,
+            /* .profit = */ (double) selected_items.size(),
+            /* .weight = */ best_weight,
+            /* .time_elapsed = */ time_elapsed
+        };
+    }
+
+    UnitDPSolution StreamingUnitDP::solve(const std::vector<double>& weights) {
+        for(const auto weight : weights) {
+            push(weight);
+        }
+
+        return finish();
+    }
+
+    UnitDPSolution StreamingUnitDP::solve(std::istream& weights) {
+        double weight;
+
+        while(weights >> weight) {
+            push(weight);
+        }
+
+        if(!weights.eof()) {
+            throw std::invalid_argument("Cannot read the weight of item " + std::to_string(n_items) + "!");
+        }
+
+        return finish();
+    }
+
+    StreamingUnitDP::NodeId StreamingUnitDP::create_node(std::size_t item, NodeId predecessor) {
+        if(predecessor != NONE) {
+            ++nodes[predecessor].n_references;
+        }
+
+        if(free_nodes.empty()) {
+            nodes.push_back(PathNode{item, predecessor, 1u});
+            return nodes.size() - 1u;
+        }
+
+        const auto node = free_nodes.back();
+        free_nodes.pop_back();
+        nodes[node] = PathNode{item, predecessor, 1u};
+        return node;
+    }
+
+    void StreamingUnitDP::release_node(NodeId node) {
+        while(node != NONE) {
+            assert(nodes[node].n_references > 0u);
+
+            if(--nodes[node].n_references > 0u) {
+                return;
+            }
+
+            free_nodes.push_back(node);
+            node = nodes[node].predecessor;
+        }
+    }
+
+    void StreamingUnitDP::drop_layers(std::size_t n_kept) {
+        n_layers = n_kept;
+
+        for(std::size_t s = 0u; s < columns.size(); ++s) {
+            if(column_paths[s].size() <= n_kept) {
+                continue;
+            }
+
+            for(auto l = n_kept; l < column_paths[s].size(); ++l) {
+                release_node(column_paths[s][l]);
+            }
+
+            columns[s].resize(n_kept);
+            column_paths[s].resize(n_kept);
+        }
+
+        windows.resize((n_kept > 0u) ? n_kept - 1u : 0u);
+    }
+}
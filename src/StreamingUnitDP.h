@@ -0,0 +1,168 @@
+#ifndef _STREAMING_UNIT_DP_H
+#define _STREAMING_UNIT_DP_H
+
+#include "Problem.h"
+#include "UnitProfitDP.h"
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <istream>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace kplink {
+    struct StreamingUnitDPParams {
+        /** Algorithm name. */
+        std::string algo_name;
+
+        /**
+         * Upper bound on the number of items in an optimal solution,
+         * e.g., the size of any feasible solution, or zero if unknown.
+         * 
+         * The working memory is O(max_distance * max_items), plus the
+         * paths of the kept entries. Without a bound, it grows with the
+         * number of items read until the first feasible solution is found.
+         */
+        std::size_t max_items = 0u;
+
+        /** Header for csv files. */
+        static const std::string csv_header;
+
+        /** Export to comma-separated list. */
+        [[nodiscard]] std::string to_csv() const;
+    };
+
+    /**
+     * Unit-profit Dynamic Programming algorithm which reads the weights
+     * of the items one at a time, e.g., from a stream, without storing
+     * them.
+     * 
+     * It computes the same table W(i, l) as UnitDP, one column (item)
+     * at a time instead of one layer at a time. Column i only depends
+     * on the columns of the max_distance items before it, so only the
+     * last max_distance + 1 columns are kept, each with the layers
+     * l = 0, ..., max_items - 1. For each layer, a monotonic queue keeps
+     * the maximum over the window of predecessors, as in UnitDP.
+     * 
+     * Instead of a table of predecessors, each entry refers to a node
+     * of a shared tree of paths, which records its item and the node of
+     * its predecessor. Nodes are reference-counted and freed as soon as
+     * no kept entry leads to them, so the tree only holds the paths of
+     * the kept entries and of the best solution found so far.
+     */
+    struct StreamingUnitDP {
+        /** Minimum weight of a feasible solution. */
+        const double min_weight;
+
+        /** Maximum distance between consecutive selected items. */
+        const std::size_t max_distance;
+
+        /** Algorithm parameters. */
+        const StreamingUnitDPParams params;
+
+        /** Builds the algorithm object, before reading any item. */
+        StreamingUnitDP(double min_weight, std::size_t max_distance, StreamingUnitDPParams params);
+
+        /**
+         * Upper bound on the number of items in an optimal solution of
+         * a unit-profit instance: the size of the GreedyHeuristic's
+         * solution, or p.n_items if the instance is infeasible.
+         */
+        [[nodiscard]] static std::size_t greedy_max_items(const Problem& p);
+
+        /** Reads the weight of the next item. */
+        void push(double weight);
+
+        /**
+         * Returns the optimal solution among the items read so far.
+         * The selected items are from the last to the first one.
+         */
+        [[nodiscard]] UnitDPSolution finish() const;
+
+        /** Reads the weights of all items, in order, and returns the optimal solution. */
+        [[nodiscard]] UnitDPSolution solve(const std::vector<double>& weights);
+
+        /**
+         * Reads whitespace-separated weights from a stream until its
+         * end, and returns the optimal solution.
+         */
+        [[nodiscard]] UnitDPSolution solve(std::istream& weights);
+
+    private:
+        /** Identifier of a node in the tree of paths. */
+        using NodeId = std::size_t;
+
+        /** Null node, used as predecessor of the first item of a path. */
+        static constexpr NodeId NONE = std::numeric_limits<NodeId>::max();
+
+        /** Value of the entries of the Dynamic Programming table which are not defined. */
+        static constexpr double UNDEFINED = std::numeric_limits<double>::quiet_NaN();
+
+        /** Node of the tree of paths: an item and the node of its predecessor. */
+        struct PathNode {
+            std::size_t item;
+            NodeId predecessor;
+            std::size_t n_references;
+        };
+
+        /** Time when the algorithm object was built. */
+        std::chrono::steady_clock::time_point start_time;
+
+        /** Number of items read so far, i.e., index of the next item. */
+        std::size_t n_items = 0u;
+
+        /**
+         * Number of layers kept. Once a solution with l+1 items is
+         * found, only smaller solutions are of interest, and only the
+         * layers 0, ..., l-1 are kept.
+         */
+        std::size_t n_layers;
+
+        /**
+         * Last max_distance + 1 columns of the Dynamic Programming
+         * table, where item i uses column slot(i). Entry l of the column
+         * of item i is W(i, l), or ::UNDEFINED if no subset of l+1 items
+         * ending with i satisfies the linking constraints. The column of
+         * item i has min(i + 1, n_layers) entries.
+         */
+        std::vector<std::vector<double>> columns;
+
+        /** Node of the tree of paths of each entry of ::columns, or ::NONE. */
+        std::vector<std::vector<NodeId>> column_paths;
+
+        /**
+         * For each layer l, the items j in the window of predecessors of
+         * the next item with a defined W(j, l), by non-increasing weight.
+         */
+        std::vector<std::deque<std::size_t>> windows;
+
+        /** Nodes of the tree of paths. */
+        std::vector<PathNode> nodes;
+
+        /** Nodes which are no longer used and can be recycled. */
+        std::vector<NodeId> free_nodes;
+
+        /** Node of the last item of the best solution found so far, or ::NONE. */
+        NodeId best_path = NONE;
+
+        /** Weight of the best solution found so far. */
+        double best_weight = 0.0;
+
+        /** Index in ::columns of the column of an item. */
+        [[nodiscard]] std::size_t slot(std::size_t item) const {
+            return item % (max_distance + 1u);
+        }
+
+        /** Creates a path node for an item following a (possibly null) predecessor. */
+        [[nodiscard]] NodeId create_node(std::size_t item, NodeId predecessor);
+
+        /** Drops a reference to a path node, freeing it and its unused predecessors. */
+        void release_node(NodeId node);
+
+        /** Stops keeping the layers from `n_kept` on, releasing their paths. */
+        void drop_layers(std::size_t n_kept);
+    };
+}
+
+#endif
\ No newline at end of file
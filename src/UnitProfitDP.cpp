@@ -7,15 +7,32 @@
 #include <cassert>
 #include <iostream>
 #include <chrono>
+#include <cmath>
+#include <stdexcept>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <numeric>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    #define KPLINK_UNIT_DP_AVX2
+    #include <immintrin.h>
+#endif
 
 namespace kplink {
     const std::string UnitDPParams::csv_header =
-        "algo_name";
+        "algo_name,rolling_layers,n_threads,use_simd";
     const std::string UnitDPSolution::csv_header =
         "n_selected_items,selected_items,profit,weight,time_elapsed";
+    const std::string UnitDPFrontier::csv_header =
+        "n_items,weight,last_item,selected_items";
 
     std::string UnitDPParams::to_csv() const {
-        return algo_name;
+        return algo_name + "," +
+               std::to_string(rolling_layers) + "," +
+               std::to_string(n_threads) + "," +
+               std::to_string(use_simd);
     }
 
     std::string UnitDPSolution::to_csv() const {
@@ -30,89 +47,376 @@ namespace kplink {
                std::to_string(time_elapsed);
     }
 
-    UnitDPSolution UnitDP::solve() {
-        table.resize(p.n_items * (p.n_items + 1u) / 2 - 1u);
-        predecessor.resize(p.n_items * (p.n_items + 1u) / 2 - 1u);
+    std::string UnitDPFrontier::to_csv(const UnitDPFrontierPoint& point, const std::vector<std::size_t>& selected_items) {
+        std::ostringstream oss;
+        std::copy(selected_items.begin(), selected_items.end(),
+            std::ostream_iterator<std::size_t>(oss, ","));
 
-        using std::chrono::steady_clock;
-        using std::chrono::duration_cast;
-        using std::chrono::milliseconds;
+        return std::to_string(point.n_items) + "," +
+               std::to_string(point.weight) + "," +
+               std::to_string(point.last_item) + "," +
+               "\"[" + oss.str() + "]\"";
+    }
 
-        const auto start_time = steady_clock::now();
+    namespace {
+        /** Number of items whose window maxima the vectorised kernel computes in one call. */
+        constexpr std::size_t KERNEL_CHUNK = 256u;
 
-        for(auto i = 0u; i < p.n_items; ++i) {
-            #ifdef DEBUG
-                std::cout << "W(" << i << ",0) = " << p.weights[i] << "\n";
+        /** Largest max_distance for which the vectorised kernel is used. */
+        constexpr std::size_t SIMD_MAX_DISTANCE = 256u;
+
+        /** Smallest number of items per worker for a layer to be split among the workers. */
+        constexpr std::size_t MIN_ITEMS_PER_WORKER = 4096u;
+
+        #ifdef KPLINK_UNIT_DP_AVX2
+            /**
+             * Computes, for each t in [0, n_items), the maximum of the
+             * entries window_end[t - k] for k = 1, ..., max_distance, and
+             * the offset k of the first maximum. Undefined (NaN) entries
+             * are ignored: if all entries are undefined, the maximum is
+             * -infinity and the offset is zero.
+             * 
+             * The maxima are built with a sparse table: after doubling
+             * the span s = 1, 2, 4, ... up to the largest power of two
+             * K <= max_distance, entry x holds the maximum of the K
+             * entries ending at x. The window of t is then covered by
+             * the two spans of K entries at its beginning and its end.
+             * Each doubling step is a single vectorised pass, four
+             * entries at a time.
+             */
+            __attribute__((target("avx2")))
+            void window_max_avx2(const double* window_end, std::size_t n_items, std::size_t max_distance, double* maxima, std::uint32_t* offsets) {
+                constexpr std::size_t BUFFER_SIZE = KERNEL_CHUNK + SIMD_MAX_DISTANCE;
+                constexpr double MINUS_INF = -std::numeric_limits<double>::infinity();
+
+                assert(n_items <= KERNEL_CHUNK);
+                assert(max_distance >= 1u && max_distance <= SIMD_MAX_DISTANCE);
+
+                // Entry x of the buffers refers to window_end[x - max_distance].
+                // The buffers alternate between the spans s and 2s.
+                alignas(32) double values[2u][BUFFER_SIZE];
+                alignas(32) double positions[2u][BUFFER_SIZE];
+                const std::size_t n_entries = n_items + max_distance - 1u;
+
+                for(std::size_t x = 0u; x < n_entries; ++x) {
+                    const double w = window_end[static_cast<std::ptrdiff_t>(x) - static_cast<std::ptrdiff_t>(max_distance)];
+
+                    values[0u][x] = std::isnan(w) ? MINUS_INF : w;
+                    positions[0u][x] = static_cast<double>(x);
+                }
+
+                std::size_t span = 1u;
+                std::size_t current = 0u;
+
+                while(2u * span <= max_distance) {
+                    const double* earlier_values = values[current];
+                    const double* earlier_positions = positions[current];
+                    double* next_values = values[1u - current];
+                    double* next_positions = positions[1u - current];
+
+                    // Entries x < span - 1 of the current buffer are not written,
+                    // so the first entry with a full span of 2 * span is 2 * span - 1.
+                    std::size_t x = 2u * span - 1u;
+
+                    // On ties, the earlier entry is kept.
+                    for(; x + 4u <= n_entries; x += 4u) {
+                        const __m256d earlier = _mm256_loadu_pd(earlier_values + x - span);
+                        const __m256d later = _mm256_loadu_pd(earlier_values + x);
+                        const __m256d better = _mm256_cmp_pd(later, earlier, _CMP_GT_OQ);
+
+                        _mm256_storeu_pd(next_values + x, _mm256_blendv_pd(earlier, later, better));
+                        _mm256_storeu_pd(next_positions + x, _mm256_blendv_pd(
+                            _mm256_loadu_pd(earlier_positions + x - span), _mm256_loadu_pd(earlier_positions + x), better));
+                    }
+
+                    for(; x < n_entries; ++x) {
+                        const bool better = earlier_values[x] > earlier_values[x - span];
+
+                        next_values[x] = better ? earlier_values[x] : earlier_values[x - span];
+                        next_positions[x] = better ? earlier_positions[x] : earlier_positions[x - span];
+                    }
+
+                    current = 1u - current;
+                    span *= 2u;
+                }
+
+                // The window of t covers entries t, ..., t + max_distance - 1.
+                const double* span_values = values[current];
+                const double* span_positions = positions[current];
+                const std::size_t first_end = span - 1u;
+                const std::size_t last_end = max_distance - 1u;
+
+                for(std::size_t t = 0u; t < n_items; ++t) {
+                    const bool better = span_values[t + last_end] > span_values[t + first_end];
+                    const double best = better ? span_values[t + last_end] : span_values[t + first_end];
+                    const double position = better ? span_positions[t + last_end] : span_positions[t + first_end];
+
+                    maxima[t] = best;
+                    offsets[t] = (best == MINUS_INF) ? 0u :
+                        static_cast<std::uint32_t>(t + max_distance - static_cast<std::size_t>(position));
+                }
+            }
+        #endif
+
+        /** Whether the processor running the program supports AVX2 instructions. */
+        bool cpu_supports_avx2() {
+            #ifdef KPLINK_UNIT_DP_AVX2
+                return __builtin_cpu_supports("avx2");
+            #else
+                return false;
             #endif
-            
-            W(i, 0u) = p.weights[i];
+        }
+    }
+
+    /**
+     * Threads which run the same job together, once for each layer of
+     * the Dynamic Programming table, and wait for each other at the
+     * end. The threads are started only once, as a layer can take less
+     * time than starting them.
+     */
+    class LayerWorkers {
+    public:
+        /** Starts the workers: the calling thread is worker 0. */
+        explicit LayerWorkers(std::size_t n_workers) {
+            for(std::size_t worker = 1u; worker < n_workers; ++worker) {
+                threads.emplace_back(&LayerWorkers::work, this, worker);
+            }
+        }
+
+        ~LayerWorkers() {
+            {
+                std::lock_guard<std::mutex> lock{mutex};
+                stopping = true;
+            }
+            start.notify_all();
+
+            for(auto& thread : threads) {
+                thread.join();
+            }
         }
 
-        for(auto l = 1u; l < p.n_items; ++l) {
-            for(auto i = l; i < p.n_items; ++i) {
-                const std::size_t start_idx =
-                    (i >= p.max_distance) ?
-                    i - p.max_distance :
-                    0u;
+        /** Number of workers, including the calling thread. */
+        [[nodiscard]] std::size_t size() const {
+            return threads.size() + 1u;
+        }
 
-                double maxW = std::numeric_limits<double>::lowest();
-                std::size_t pred = 0u;
+        /** Runs a job, which gets the worker index, on all workers and waits for them to finish. */
+        void run(const std::function<void(std::size_t)>& new_job) {
+            {
+                std::lock_guard<std::mutex> lock{mutex};
+                job = &new_job;
+                n_running = threads.size();
+                ++generation;
+            }
+            start.notify_all();
 
-                #ifdef DEBUG
-                    std::cout << "W(" << i << "," << l << ") = max { ";
-                #endif
+            new_job(0u);
 
-                for(auto j = start_idx; j <= i - 1u; ++j) {
-                    const auto w = W(j, l - 1u);
+            std::unique_lock<std::mutex> lock{mutex};
+            done.wait(lock, [&] { return n_running == 0u; });
+        }
 
-                    assert(w);
+    private:
+        std::vector<std::thread> threads;
+        std::mutex mutex;
+        std::condition_variable start;
+        std::condition_variable done;
+        const std::function<void(std::size_t)>* job = nullptr;
+        std::size_t generation = 0u;
+        std::size_t n_running = 0u;
+        bool stopping = false;
 
-                    #ifdef DEBUG
-                        std::cout << *w << ((j < i - 1u) ? ", " : " ");
-                    #endif
+        void work(std::size_t worker) {
+            std::size_t last_generation = 0u;
 
-                    if(*w > maxW) {
-                        maxW = *w;
-                        pred = j;
-                    }
+            while(true) {
+                std::unique_lock<std::mutex> lock{mutex};
+                start.wait(lock, [&] { return stopping || generation != last_generation; });
+
+                if(stopping) {
+                    return;
                 }
 
-                #ifdef DEBUG
-                    std::cout << "} + " << p.weights[i] << " = ";
-                    std::cout << maxW << " + " << p.weights[i] << " = ";
-                    std::cout << (maxW + p.weights[i]) << "\n";
-                #endif
+                last_generation = generation;
+                const auto current_job = job;
+                lock.unlock();
 
-                assert(maxW < std::numeric_limits<double>::max());
+                (*current_job)(worker);
 
-                W(i, l) = maxW + p.weights[i];
-                P(i, l) = pred;
+                lock.lock();
+                if(--n_running == 0u) {
+                    done.notify_one();
+                }
             }
         }
+    };
 
-        std::size_t min_sz = p.n_items;
-        std::size_t min_i = p.n_items;
-        double weight = 0.0;
+    template<typename Store>
+    bool UnitDP::compute_layer(std::size_t l, std::size_t first_item, const double* previous, LayerWorkers& workers, const Store& store) {
+        const std::size_t n_entries = p.n_items - first_item;
+        const std::size_t n_blocks = (n_entries >= workers.size() * MIN_ITEMS_PER_WORKER) ?
+            workers.size() : 1u;
+
+        if(n_blocks == 1u) {
+            return compute_layer_block(l, first_item, p.n_items, previous, windows[0u], store);
+        }
+
+        std::vector<char> any_defined(n_blocks, false);
+
+        workers.run([&] (std::size_t block) -> void {
+            any_defined[block] = compute_layer_block(l,
+                first_item + block * n_entries / n_blocks,
+                first_item + (block + 1u) * n_entries / n_blocks,
+                previous, windows[block], store);
+        });
+
+        return std::any_of(any_defined.begin(), any_defined.end(), [] (char b) { return b != 0; });
+    }
 
-        for(auto i = 0u; i < p.n_items; ++i) {
-            for(auto l = 0u; l <= i; ++l) {
-                assert(W(i, l));
+    template<typename Store>
+    bool UnitDP::compute_layer_block(std::size_t l, std::size_t first_item, std::size_t last_item, const double* previous, std::deque<std::size_t>& window, const Store& store) const {
+        // W(j, l - 1) is previous[j - (l - 1)], for j >= l - 1.
+        const auto W_previous = [&] (std::size_t j) -> double { return previous[j - l + 1u]; };
 
-                if(*W(i, l) >= p.min_weight && l < min_sz) {
-                    min_sz = l;
-                    min_i = i;
-                    weight = *W(i, l);
+        // First item of the window of predecessors of item i.
+        const auto window_start = [&] (std::size_t i) -> std::size_t {
+            return (i >= p.max_distance + l - 1u) ? i - p.max_distance : l - 1u;
+        };
+
+        // The items from `first_full_window` on have all their window
+        // in layer l - 1, and the vectorised kernel can be used for them.
+        const std::size_t first_full_window = use_avx2 ?
+            std::clamp(p.max_distance + l - 1u, first_item, last_item) : last_item;
+
+        bool any_defined = false;
+
+        // Candidate predecessors j of the current item i, i.e., those
+        // in the window [max(i - max_distance, l - 1), i - 1] with a
+        // defined W(j, l - 1). Their weights W(j, l - 1) are
+        // non-increasing from front to back, and equal weights are in
+        // item order, so the front is the first maximum.
+        const auto enter_window = [&] (std::size_t j) -> void {
+            const double w = W_previous(j);
+
+            // Comparisons with the undefined entries, which are NaN, are always false.
+            if(std::isnan(w)) {
+                return;
+            }
+
+            // Items with a lower weight before j can never be the maximum again.
+            while(!window.empty() && W_previous(window.back()) < w) {
+                window.pop_back();
+            }
+            window.push_back(j);
+        };
+
+        window.clear();
+
+        for(auto j = window_start(first_item); j + 1u < first_item; ++j) {
+            enter_window(j);
+        }
+
+        for(auto i = first_item; i < first_full_window; ++i) {
+            enter_window(i - 1u);
+
+            while(!window.empty() && window.front() < window_start(i)) {
+                window.pop_front();
+            }
+
+            if(window.empty()) {
+                // No subset of l items can precede item i.
+                continue;
+            }
+
+            const std::size_t pred = window.front();
+            const double maxW = W_previous(pred);
+
+            #ifdef DEBUG
+                std::cout << "W(" << i << "," << l << ") = W(" << pred << "," << (l - 1u) << ") + " << weights[i] << " = ";
+                std::cout << maxW << " + " << weights[i] << " = ";
+                std::cout << (maxW + weights[i]) << "\n";
+            #endif
+
+            store(i, maxW + weights[i], pred);
+            any_defined = true;
+        }
+
+        #ifdef KPLINK_UNIT_DP_AVX2
+            double maxima[KERNEL_CHUNK];
+            std::uint32_t offsets[KERNEL_CHUNK];
+
+            for(auto i = first_full_window; i < last_item; i += KERNEL_CHUNK) {
+                const std::size_t n_chunk = std::min(KERNEL_CHUNK, last_item - i);
+
+                window_max_avx2(previous + (i - l + 1u), n_chunk, p.max_distance, maxima, offsets);
+
+                for(std::size_t t = 0u; t < n_chunk; ++t) {
+                    if(offsets[t] == 0u) {
+                        continue;
+                    }
+
+                    store(i + t, maxima[t] + weights[i + t], i + t - offsets[t]);
+                    any_defined = true;
                 }
             }
+        #endif
+
+        return any_defined;
+    }
+
+    UnitDPSolution UnitDP::solve() {
+        const auto start_time = std::chrono::steady_clock::now();
+
+        // The vectorised kernel scans the whole window of each item,
+        // while the scalar one takes amortised constant time per item.
+        use_avx2 = params.use_simd && p.max_distance <= SIMD_MAX_DISTANCE && cpu_supports_avx2();
+
+        LayerWorkers workers{std::max<std::size_t>(params.n_threads, 1u)};
+        windows.resize(workers.size());
+
+        const auto selected_items = params.rolling_layers ?
+            solve_rolling_layers(workers) : solve_full_table(workers);
+
+        return make_solution(selected_items, start_time);
+    }
+
+    UnitDPSolution UnitDP::update_weights(const std::vector<double>& new_weights) {
+        const auto start_time = std::chrono::steady_clock::now();
+
+        if(new_weights.size() != p.n_items) {
+            throw std::invalid_argument("The new weights must have one entry for each item.");
         }
 
-        std::vector<std::size_t> selected_items = {{ min_i }};
-        std::size_t current_l = min_sz;
-        std::size_t current_i = *P(min_i, current_l);
+        if(params.rolling_layers) {
+            throw std::logic_error("Trying to update the weights of a Unit-Profit DP which does not keep its table.");
+        }
 
-        while(current_l >= 1u) {
-            selected_items.push_back(current_i);
-            current_i = *P(current_i, --current_l);
+        use_avx2 = params.use_simd && p.max_distance <= SIMD_MAX_DISTANCE && cpu_supports_avx2();
+
+        LayerWorkers workers{std::max<std::size_t>(params.n_threads, 1u)};
+        windows.resize(workers.size());
+
+        const auto first_changed = static_cast<std::size_t>(std::distance(weights.begin(),
+            std::mismatch(weights.begin(), weights.end(), new_weights.begin()).first));
+
+        weights = new_weights;
+
+        if(layer_begin.empty()) {
+            return make_solution(solve_full_table(workers), start_time);
+        }
+
+        return make_solution(resume_full_table(first_changed, workers), start_time);
+    }
+
+    UnitDPSolution UnitDP::make_solution(const std::vector<std::size_t>& selected_items, std::chrono::steady_clock::time_point start_time) const {
+        using std::chrono::steady_clock;
+        using std::chrono::duration_cast;
+        using std::chrono::milliseconds;
+
+        double weight = 0.0;
+
+        for(const auto item : selected_items) {
+            weight += weights[item];
         }
 
         const auto end_time = steady_clock::now();
@@ -120,10 +424,284 @@ namespace kplink {
 
         return UnitDPSolution{
             /* .selected_items = */ selected_items,
-            /* .profit = */ (double) (min_sz + 1u),
+            /* .profit = */ (double) selected_items.size(),
             /* .weight = */ weight,
             /* .time_elapsed = */ time_elapsed
         };
     }
+
+    UnitDPFrontier UnitDP::solve_frontier(double max_weight) {
+        using std::chrono::steady_clock;
+        using std::chrono::duration_cast;
+        using std::chrono::milliseconds;
+
+        const auto start_time = steady_clock::now();
+
+        use_avx2 = params.use_simd && p.max_distance <= SIMD_MAX_DISTANCE && cpu_supports_avx2();
+
+        LayerWorkers workers{std::max<std::size_t>(params.n_threads, 1u)};
+        windows.resize(workers.size());
+
+        start_table();
+
+        // Relative tolerance on the total weight, as the table sums the weights in another order.
+        const double total_weight = std::accumulate(weights.begin(), weights.end(), 0.0) * (1.0 - 1e-12);
+        std::vector<UnitDPFrontierPoint> points;
+
+        while(true) {
+            const std::size_t l = layer_begin.size() - 1u;
+            const auto begin = table.begin() + static_cast<std::ptrdiff_t>(layer_begin[l]);
+
+            // Undefined entries, which are NaN, are never the maximum: the
+            // first entry of each layer, with items 0, ..., l, is defined.
+            const auto best = std::max_element(begin, table.end(),
+                [] (double w1, double w2) -> bool { return std::isnan(w1) || w1 < w2; });
+
+            points.push_back(UnitDPFrontierPoint{
+                /* .n_items = */ l + 1u,
+                /* .weight = */ *best,
+                /* .last_item = */ l + static_cast<std::size_t>(std::distance(begin, best))
+            });
+
+            if(*best >= max_weight || *best >= total_weight || l + 1u == p.n_items || !add_layer(workers)) {
+                break;
+            }
+        }
+
+        if(layer_begin.size() > points.size()) {
+            // The last layer added has no defined entries.
+            table.resize(layer_begin.back());
+            predecessor.resize(layer_begin.back());
+            layer_begin.pop_back();
+        }
+
+        const auto end_time = steady_clock::now();
+        const auto time_elapsed = duration_cast<milliseconds>(end_time - start_time).count() / 1000.0;
+
+        return UnitDPFrontier{
+            /* .points = */ points,
+            /* .time_elapsed = */ time_elapsed
+        };
+    }
+
+    std::vector<std::size_t> UnitDP::frontier_items(const UnitDPFrontierPoint& point) const {
+        if(point.n_items == 0u || point.n_items > layer_begin.size()) {
+            throw std::out_of_range("The frontier point is not in the Dynamic Programming table.");
+        }
+
+        std::vector<std::size_t> selected_items = {{ point.last_item }};
+        std::size_t current_i = point.last_item;
+
+        for(auto current_l = point.n_items - 1u; current_l >= 1u; --current_l) {
+            current_i = P(current_i, current_l);
+            selected_items.push_back(current_i);
+        }
+
+        return selected_items;
+    }
+
+    UnitDPSolution UnitDP::solve_from_frontier(const UnitDPFrontier& frontier, double min_weight) const {
+        const auto point = std::find_if(frontier.points.begin(), frontier.points.end(),
+            [&] (const UnitDPFrontierPoint& pt) -> bool { return pt.weight >= min_weight; });
+
+        if(point == frontier.points.end()) {
+            throw std::runtime_error("No feasible solution: the instance is infeasible!");
+        }
+
+        return UnitDPSolution{
+            /* .selected_items = */ frontier_items(*point),
+            /* .profit = */ (double) point->n_items,
+            /* .weight = */ point->weight,
+            /* .time_elapsed = */ frontier.time_elapsed
+        };
+    }
+
+    void UnitDP::start_table() {
+        table.clear();
+        predecessor.clear();
+        long_predecessor_offsets.clear();
+        layer_begin.clear();
+
+        #ifdef DEBUG
+            for(auto i = 0u; i < p.n_items; ++i) {
+                std::cout << "W(" << i << ",0) = " << weights[i] << "\n";
+            }
+        #endif
+
+        // Layer 0: subsets of a single item, whose predecessor offsets are never read.
+        layer_begin.push_back(0u);
+        table.assign(weights.begin(), weights.end());
+        predecessor.resize(p.n_items);
+    }
+
+    bool UnitDP::add_layer(LayerWorkers& workers) {
+        const std::size_t l = layer_begin.size();
+
+        layer_begin.push_back(table.size());
+        table.resize(table.size() + p.n_items - l, UNDEFINED);
+        predecessor.resize(table.size());
+
+        return compute_layer(l, l, table.data() + layer_begin[l - 1u], workers,
+            [&] (std::size_t i, double weight, std::size_t pred) -> void {
+                W(i, l) = weight;
+                set_P(i, l, pred);
+            });
+    }
+
+    void UnitDP::recompute_layer_suffix(std::size_t l, std::size_t first_item, LayerWorkers& workers) {
+        const std::size_t first_i = std::max(first_item, l);
+
+        if(first_i >= p.n_items) {
+            return;
+        }
+
+        const auto begin = table.begin() + static_cast<std::ptrdiff_t>(position(first_i, l));
+        std::fill(begin, begin + static_cast<std::ptrdiff_t>(p.n_items - first_i), UNDEFINED);
+
+        compute_layer(l, first_i, table.data() + layer_begin[l - 1u], workers,
+            [&] (std::size_t i, double weight, std::size_t pred) -> void {
+                W(i, l) = weight;
+                set_P(i, l, pred);
+            });
+    }
+
+    std::vector<std::size_t> UnitDP::solve_full_table(LayerWorkers& workers) {
+        start_table();
+
+        return resume_full_table(p.n_items, workers);
+    }
+
+    std::vector<std::size_t> UnitDP::resume_full_table(std::size_t first_item, LayerWorkers& workers) {
+        // End of layer l in the table: the beginning of the next layer, if any.
+        const auto layer_end = [&] (std::size_t l) -> DPTable::const_iterator {
+            return (l + 1u < layer_begin.size()) ?
+                table.begin() + static_cast<std::ptrdiff_t>(layer_begin[l + 1u]) : table.end();
+        };
+
+        if(first_item < p.n_items) {
+            std::copy(weights.begin() + static_cast<std::ptrdiff_t>(first_item), weights.end(),
+                table.begin() + static_cast<std::ptrdiff_t>(first_item));
+        }
+
+        std::size_t min_sz = 0u;
+        std::size_t min_i = first_feasible_item(table.begin(), layer_end(0u), 0u);
+
+        while(min_i == p.n_items && min_sz + 1u < p.n_items) {
+            const std::size_t l = ++min_sz;
+
+            if(l < layer_begin.size()) {
+                recompute_layer_suffix(l, first_item, workers);
+            } else if(!add_layer(workers)) {
+                // No subset of l+1 items, hence no larger subset, satisfies the linking constraints.
+                break;
+            }
+
+            min_i = first_feasible_item(table.begin() + static_cast<std::ptrdiff_t>(layer_begin[l]), layer_end(l), l);
+        }
+
+        if(min_sz + 1u < layer_begin.size()) {
+            // The layers after the optimal one were not recomputed.
+            table.resize(layer_begin[min_sz + 1u]);
+            predecessor.resize(table.size());
+            layer_begin.resize(min_sz + 1u);
+        }
+
+        if(min_i == p.n_items) {
+            throw std::runtime_error("No feasible solution: the instance is infeasible!");
+        }
+
+        std::vector<std::size_t> selected_items = {{ min_i }};
+        std::size_t current_i = min_i;
+
+        for(auto current_l = min_sz; current_l >= 1u; --current_l) {
+            current_i = P(current_i, current_l);
+            selected_items.push_back(current_i);
+        }
+
+        return selected_items;
+    }
+
+    std::vector<std::size_t> UnitDP::solve_rolling_layers(LayerWorkers& workers) {
+        checkpoint_spacing = std::max<std::size_t>(
+            static_cast<std::size_t>(std::ceil(std::sqrt(static_cast<double>(p.n_items)))), 1u);
+        checkpoints.clear();
+
+        DPLayer previous(weights.begin(), weights.end());
+        DPLayer current(p.n_items);
+
+        checkpoints.push_back(previous);
+
+        std::size_t min_sz = 0u;
+        std::size_t min_i = first_feasible_item(previous.begin(), previous.end(), 0u);
+
+        while(min_i == p.n_items && min_sz + 1u < p.n_items) {
+            const std::size_t l = ++min_sz;
+
+            std::fill(current.begin(), current.end(), UNDEFINED);
+            const bool any_defined = compute_layer(l, l, previous.data() + l - 1u, workers,
+                [&] (std::size_t i, double weight, std::size_t) -> void { current[i] = weight; });
+            std::swap(previous, current);
+
+            if(!any_defined) {
+                // No subset of l+1 items, hence no larger subset, satisfies the linking constraints.
+                break;
+            }
+
+            if(l % checkpoint_spacing == 0u) {
+                checkpoints.push_back(previous);
+            }
+
+            min_i = first_feasible_item(previous.begin(), previous.end(), 0u);
+        }
+
+        if(min_i == p.n_items) {
+            throw std::runtime_error("No feasible solution: the instance is infeasible!");
+        }
+
+        std::vector<std::size_t> selected_items = {{ min_i }};
+        std::size_t current_i = min_i;
+        std::size_t current_l = min_sz;
+        std::vector<std::vector<std::size_t>> segment_predecessors;
+
+        while(current_l >= 1u) {
+            // Last checkpoint strictly before the current layer.
+            const std::size_t checkpoint = (current_l - 1u) / checkpoint_spacing;
+            const std::size_t first_l = checkpoint * checkpoint_spacing;
+
+            previous = checkpoints[checkpoint];
+            segment_predecessors.assign(current_l - first_l, std::vector<std::size_t>(p.n_items));
+
+            for(auto l = first_l + 1u; l <= current_l; ++l) {
+                auto& predecessors = segment_predecessors[l - first_l - 1u];
+
+                std::fill(current.begin(), current.end(), UNDEFINED);
+                compute_layer(l, l, previous.data() + l - 1u, workers,
+                    [&] (std::size_t i, double weight, std::size_t pred) -> void {
+                        current[i] = weight;
+                        predecessors[i] = pred;
+                    });
+                std::swap(previous, current);
+            }
+
+            for(; current_l > first_l; --current_l) {
+                current_i = segment_predecessors[current_l - first_l - 1u][current_i];
+                selected_items.push_back(current_i);
+            }
+        }
+
+        return selected_items;
+    }
+
+    std::size_t UnitDP::first_feasible_item(DPLayer::const_iterator begin, DPLayer::const_iterator end, std::size_t first_item) const {
+        // Comparisons with the undefined entries, which are NaN, are always false.
+        const auto it = std::find_if(begin, end,
+            [&] (double w) -> bool { return w >= p.min_weight; });
+
+        if(it == end) {
+            return p.n_items;
+        }
+
+        return first_item + static_cast<std::size_t>(std::distance(begin, it));
+    }
 }
 
@@ -5,13 +5,44 @@
 #include <string>
 #include <vector>
 #include <algorithm>
-#include <optional>
+#include <deque>
+#include <limits>
+#include <cstdint>
+#include <unordered_map>
+#include <mutex>
+#include <chrono>
 
 namespace kplink {
+    class LayerWorkers;
+
     struct UnitDPParams {
         /** Algorithm name. */
         std::string algo_name;
 
+        /**
+         * Keep only two layers of the Dynamic Programming table, plus
+         * a checkpoint layer every sqrt(n_items) layers, instead of the
+         * whole table.
+         * 
+         * Memory drops from O(n_items^2) to O(n_items * sqrt(n_items)),
+         * at the cost of recomputing the layers between checkpoints
+         * once, to reconstruct the selected items.
+         */
+        bool rolling_layers = false;
+
+        /**
+         * Number of threads which compute each layer of the Dynamic
+         * Programming table together, each on a block of items.
+         */
+        std::size_t n_threads = 1u;
+
+        /**
+         * Use the vectorised (AVX2) computation of the window maxima,
+         * if the processor supports it and max_distance is small.
+         * Otherwise, the scalar computation is used.
+         */
+        bool use_simd = true;
+
         /** Header for csv files. */
         static const std::string csv_header;
 
@@ -23,7 +54,7 @@ namespace kplink {
         /** Selected items. */
         std::vector<std::size_t> selected_items;
 
-        /** Profit collected (== number of items). */
+        /** Profit collected (== number of items, with unit profits). */
         double profit;
 
         /** Weight collected. */
@@ -39,6 +70,40 @@ namespace kplink {
         [[nodiscard]] std::string to_csv() const;
     };
 
+    struct UnitDPFrontierPoint {
+        /** Number of selected items (== profit). */
+        std::size_t n_items;
+
+        /** Highest weight collected by n_items items which satisfy the linking constraints. */
+        double weight;
+
+        /**
+         * Last of the items which collect the weight. Together with
+         * n_items, it identifies the entry of the Dynamic Programming
+         * table from which UnitDP::frontier_items rebuilds them.
+         */
+        std::size_t last_item;
+    };
+
+    struct UnitDPFrontier {
+        /**
+         * One point for each number of items which can satisfy the
+         * linking constraints, by increasing number of items. Weights
+         * are non-decreasing: removing the first item of a subset keeps
+         * the linking constraints satisfied.
+         */
+        std::vector<UnitDPFrontierPoint> points;
+
+        /** Time elapsed in seconds. */
+        double time_elapsed;
+
+        /** Header for csv files, with one row per point. */
+        static const std::string csv_header;
+
+        /** Export a point, and the items which achieve it, to comma-separated list. */
+        [[nodiscard]] static std::string to_csv(const UnitDPFrontierPoint& point, const std::vector<std::size_t>& selected_items);
+    };
+
     struct UnitDP {
         /** Problem instance. */
         const Problem& p;
@@ -47,7 +112,7 @@ namespace kplink {
         const UnitDPParams params;
 
         /** Builds the algorithm object from the problem instance. */
-        UnitDP(const Problem& p, const UnitDPParams params) : p{p}, params{params} {
+        UnitDP(const Problem& p, const UnitDPParams params) : p{p}, params{params}, weights{p.weights} {
             if(std::any_of(p.profits.begin(), p.profits.end(), [&] (auto pr) { return pr != 1.0; })) {
                 throw std::logic_error("Trying to use the Unit-Profit DP on an instance which does not have unit profits.");
             }
@@ -56,41 +121,256 @@ namespace kplink {
         /** Executes the labelling algorithm. */
         [[nodiscard]] UnitDPSolution solve();
 
+        /**
+         * Replaces the weights of the items, e.g., after an iteration
+         * which changes a few of them, and returns the new optimal
+         * solution.
+         * 
+         * The object keeps its Dynamic Programming table between calls:
+         * the entries W(i, l) of the items i before the first changed one
+         * are still valid, so only those of the later items are
+         * recomputed, one layer at a time up to the first layer with a
+         * feasible entry. If the table was never filled, it is computed
+         * from scratch. Not available with params.rolling_layers.
+         */
+        [[nodiscard]] UnitDPSolution update_weights(const std::vector<double>& new_weights);
+
+        /**
+         * Computes the highest weight achievable with each number of
+         * items, independently of the minimum weight, so that any
+         * number of minimum weights can be answered with
+         * solve_from_frontier. The whole Dynamic Programming table is
+         * kept, whatever params.rolling_layers, to rebuild the items of
+         * each point.
+         * 
+         * Layers are computed until none of their entries is defined,
+         * or until the first layer whose highest weight reaches
+         * `max_weight`: no minimum weight up to `max_weight` needs the
+         * layers after it. They also stop once the highest weight
+         * reaches the total weight of the items (up to rounding), as no
+         * larger subset collects more. Without a finite `max_weight`,
+         * the table can grow to O(n_items^2) entries.
+         */
+        [[nodiscard]] UnitDPFrontier solve_frontier(double max_weight);
+
+        /**
+         * Items which achieve a point of the last frontier computed by
+         * solve_frontier, from the last to the first one.
+         */
+        [[nodiscard]] std::vector<std::size_t> frontier_items(const UnitDPFrontierPoint& point) const;
+
+        /**
+         * Optimal solution for a minimum weight, from a frontier computed
+         * by solve_frontier: the first point reaching the minimum weight.
+         * Its elapsed time is that of the frontier.
+         */
+        [[nodiscard]] UnitDPSolution solve_from_frontier(const UnitDPFrontier& frontier, double min_weight) const;
+
     private:
+        /** Value of the entries of the Dynamic Programming table which are not defined. */
+        static constexpr double UNDEFINED = std::numeric_limits<double>::quiet_NaN();
+
+        /** Current weights of the items: p.weights, unless changed by update_weights. */
+        std::vector<double> weights;
+
+        /** Stored predecessor offset meaning that the actual offset is in ::long_predecessor_offsets. */
+        static constexpr std::uint8_t LONG_OFFSET = std::numeric_limits<std::uint8_t>::max();
+
+        /**
+         * Layer of the Dynamic Programming table: entry i is W(i, l) for
+         * a fixed l, or ::UNDEFINED.
+         */
+        using DPLayer = std::vector<double>;
+
         /** Data structure used to store the Dynamic Programming table.
          * 
-         *  This is a lower-triangular square matrix indexed with (i,l)
-         *  for i = 0, ..., p.n_items-1 and l = 0, ..., i-1.
+         *  This is a lower-triangular matrix indexed with (i,l)
+         *  for i = 0, ..., p.n_items-1 and l = 0, ..., i.
          *  Entry (i, l) is the highest weight achievable with a subset
          *  of items {0, ..., i} of size l+1 and such that its
-         *  highest-index element has index i.
+         *  highest-index element has index i. It is ::UNDEFINED if no
+         *  such subset satisfies the linking constraints.
+         * 
+         *  Entry (i, l) is the maximum of W(j, l-1) over the window of
+         *  items j in [i - max_distance, i - 1], plus the weight of i.
+         *  As i grows, the window slides forward by one item, so its
+         *  maximum is kept with a monotonic deque in amortised O(1),
+         *  unless the vectorised kernel is used (see compute_layer_block).
+         * 
+         *  The optimal solution has l+1 items, where l is the first layer
+         *  with an entry reaching the minimum weight. Therefore, the
+         *  matrix is built one layer at a time, allocating each layer
+         *  only when it is computed, and no layer after that is needed.
          * 
-         *  The matrix is stored flat and auxiliary function W must be
-         *  used to access its elements.
+         *  The matrix is stored flat, one layer after the other, so that
+         *  computing a layer streams through the previous one. Layer l
+         *  holds the entries for i = l, ..., p.n_items-1, starting at
+         *  position ::layer_begin[l]. Auxiliary function W must be used
+         *  to access its elements.
          */
-        using DPTable = std::vector<std::optional<double>>;
+        using DPTable = std::vector<double>;
 
         /** Similar to DPTable, but used to reconstruct the optimal solution.
          * 
-         *  Entry (i, l) stores the index of the item which achieves the
-         *  maximum in the DP recursion for W(i, l).
+         *  Entry (i, l) stores the offset i - j of the item j which
+         *  achieves the maximum in the DP recursion for W(i, l). As j
+         *  is at most max_distance items before i, the offset usually
+         *  fits in a byte: larger ones are kept in ::long_predecessor_offsets.
+         *  Auxiliary function P must be used to access its elements.
          */
-        using DPPred = std::vector<std::optional<std::size_t>>;
+        using DPPred = std::vector<std::uint8_t>;
 
         /** Dynamic Programming table of weights. */
         DPTable table;
 
-        /** Dynamic Programming table of predecessors. */
+        /** Dynamic Programming table of predecessor offsets. */
         DPPred predecessor;
 
+        /** Predecessor offsets which do not fit in ::predecessor, by position in the table. */
+        std::unordered_map<std::size_t, std::size_t> long_predecessor_offsets;
+
+        /** Protects ::long_predecessor_offsets, which different workers can update. */
+        std::mutex long_predecessor_offsets_mutex;
+
+        /** Position in ::table and ::predecessor of the first entry of each layer. */
+        std::vector<std::size_t> layer_begin;
+
+        /**
+         * Layers 0, s, 2s, ... of the Dynamic Programming table, where
+         * s is ::checkpoint_spacing. Only used with params.rolling_layers.
+         */
+        std::vector<DPLayer> checkpoints;
+
+        /** Number of layers between two consecutive ::checkpoints. */
+        std::size_t checkpoint_spacing;
+
+        /**
+         * Scratch queues of compute_layer_block, one per worker:
+         * candidate predecessors, by decreasing weight.
+         */
+        std::vector<std::deque<std::size_t>> windows;
+
+        /** Whether the window maxima are computed with the vectorised kernel. */
+        bool use_avx2 = false;
+
+        /**
+         * Computes the entries W(i, l) of layer l >= 1 for the items
+         * i >= first_item >= l, from those of layer l-1, which starts at
+         * `previous`: W(j, l-1) is previous[j - (l-1)], or ::UNDEFINED if
+         * the entry is not defined.
+         * 
+         * Every entry of layer l only depends on layer l-1, so large
+         * layers are split in contiguous blocks of items, which the
+         * workers compute in parallel with compute_layer_block.
+         * 
+         * It calls `store(i, W(i, l), P(i, l))` for each entry of layer
+         * l which is defined, possibly from different threads at the
+         * same time. The entries not stored are not defined.
+         * 
+         * Returns true iff any entry of layer l is defined.
+         */
+        template<typename Store>
+        bool compute_layer(std::size_t l, std::size_t first_item, const double* previous, LayerWorkers& workers, const Store& store);
+
+        /**
+         * Computes the entries W(i, l) for items i in [first_item,
+         * last_item), as compute_layer.
+         * 
+         * The maximum over the sliding window of predecessors is kept
+         * with a monotonic queue in `window`. Once the window of an item
+         * lies entirely in layer l-1, the maxima can instead be computed
+         * by the vectorised kernel, in chunks of items, if ::use_avx2 is set.
+         * 
+         * Returns true iff any of the entries computed is defined.
+         */
+        template<typename Store>
+        bool compute_layer_block(std::size_t l, std::size_t first_item, std::size_t last_item, const double* previous, std::deque<std::size_t>& window, const Store& store) const;
+
+        /** Clears the Dynamic Programming table and fills its layer 0. */
+        void start_table();
+
+        /**
+         * Appends the next layer to the Dynamic Programming table and
+         * computes it. Returns true iff any of its entries is defined.
+         */
+        bool add_layer(LayerWorkers& workers);
+
+        /**
+         * Fills the Dynamic Programming table up to the first layer
+         * with a feasible entry and returns the selected items, from
+         * the last to the first one.
+         */
+        [[nodiscard]] std::vector<std::size_t> solve_full_table(LayerWorkers& workers);
+
+        /**
+         * Brings the Dynamic Programming table up to date after the
+         * weights of the items from `first_item` on changed, or
+         * p.n_items if none did, and returns the selected items, as
+         * solve_full_table.
+         * 
+         * The layers already in the table are recomputed from
+         * `first_item` on, and new layers are added after them, up to
+         * the first layer with a feasible entry. The layers after it are
+         * dropped, as they are no longer up to date.
+         */
+        [[nodiscard]] std::vector<std::size_t> resume_full_table(std::size_t first_item, LayerWorkers& workers);
+
+        /** Recomputes the entries of layer l >= 1 of the table for the items from `first_item` on. */
+        void recompute_layer_suffix(std::size_t l, std::size_t first_item, LayerWorkers& workers);
+
+        /** Builds the solution with the selected items, with the time elapsed since `start_time`. */
+        [[nodiscard]] UnitDPSolution make_solution(const std::vector<std::size_t>& selected_items, std::chrono::steady_clock::time_point start_time) const;
+
+        /**
+         * Computes the Dynamic Programming table one layer at a time,
+         * up to the first layer with a feasible entry, keeping only the
+         * ::checkpoints, and returns the selected items, from the last
+         * to the first one.
+         * 
+         * The selected items are rebuilt backwards, one segment of
+         * layers between consecutive checkpoints at a time: the layers
+         * of the segment are recomputed from its first checkpoint,
+         * with their predecessors, which lead from the last item found
+         * to an item in the checkpoint's layer.
+         */
+        [[nodiscard]] std::vector<std::size_t> solve_rolling_layers(LayerWorkers& workers);
+
+        /**
+         * First item i such that W(i, l) reaches the minimum weight, in
+         * the entries [begin, end) of a layer of the Dynamic Programming
+         * table, the first of which refers to `first_item`, or p.n_items
+         * if none.
+         */
+        [[nodiscard]] std::size_t first_feasible_item(DPLayer::const_iterator begin, DPLayer::const_iterator end, std::size_t first_item) const;
+
+        /** Position of entry (i, l) in the Dynamic Programming tables. */
+        [[nodiscard]] std::size_t position(std::size_t i, std::size_t l) const {
+            return layer_begin[l] + i - l;
+        }
+
         /** Access an element of the Dynamic Programming weights table. */
-        [[nodiscard]] std::optional<double>& W(std::size_t i, std::size_t l) {
-            return table[(i + 1) * i / 2 + l];
+        [[nodiscard]] double& W(std::size_t i, std::size_t l) {
+            return table[position(i, l)];
         }
 
-        /** Access an element of the Dynamic Programming predecessors table. */
-        [[nodiscard]] std::optional<std::size_t>& P(std::size_t i, std::size_t l) {
-            return predecessor[(i + 1) * i / 2 + l];
+        /** Item which achieves the maximum in the DP recursion for W(i, l), with l >= 1. */
+        [[nodiscard]] std::size_t P(std::size_t i, std::size_t l) const {
+            const auto pos = position(i, l);
+            return i - ((predecessor[pos] == LONG_OFFSET) ? long_predecessor_offsets.at(pos) : predecessor[pos]);
+        }
+
+        /** Sets the item which achieves the maximum in the DP recursion for W(i, l). */
+        void set_P(std::size_t i, std::size_t l, std::size_t pred) {
+            const auto pos = position(i, l);
+            const auto offset = i - pred;
+
+            if(offset >= LONG_OFFSET) {
+                std::lock_guard<std::mutex> lock{long_predecessor_offsets_mutex};
+                predecessor[pos] = LONG_OFFSET;
+                long_predecessor_offsets[pos] = offset;
+            } else {
+                predecessor[pos] = static_cast<std::uint8_t>(offset);
+            }
         }
     };
 }
@@ -5,6 +5,9 @@
 #include "GreedyHeuristic.h"
 #include "InitialSolution.h"
 #include "UnitProfitDP.h"
+#include "StreamingUnitDP.h"
+#include "IntegerProfitDP.h"
+#include "BatchUnitDP.h"
 
 #include <cstdlib>
 #include <filesystem>
@@ -30,6 +33,84 @@ void export_solution_to_csv(std::filesystem::path csv_file_path, const kplink::P
     ofs << p.to_csv() << "," << params.to_csv() << "," << results.to_csv() << "\n";
 }
 
+template<typename Params, typename Results>
+void export_solutions_to_csv(std::filesystem::path csv_file_path, const std::vector<kplink::Problem>& problems, const Params& params, const std::vector<Results>& results) {
+    std::ofstream ofs{csv_file_path};
+
+    if(ofs.fail()) {
+        std::cerr << "Cannot write solutions to " << csv_file_path << ": skipping!\n";
+        return;
+    }
+
+    assert(ofs.good());
+    assert(problems.size() == results.size());
+
+    ofs << kplink::Problem::csv_header << "," << Params::csv_header << "," << Results::csv_header << "\n";
+
+    for(std::size_t k = 0u; k < problems.size(); ++k) {
+        ofs << problems[k].to_csv() << "," << params.to_csv() << "," << results[k].to_csv() << "\n";
+    }
+}
+
+void export_bucket_stats_to_csv(std::filesystem::path csv_file_path, const std::vector<kplink::LabelBucketStats>& bucket_stats) {
+    std::ofstream ofs{csv_file_path};
+
+    if(ofs.fail()) {
+        std::cerr << "Cannot write label statistics to " << csv_file_path << ": skipping!\n";
+        return;
+    }
+
+    assert(ofs.good());
+
+    ofs << "item," << kplink::LabelBucketStats::csv_header << "\n";
+
+    for(std::size_t item = 0u; item < bucket_stats.size(); ++item) {
+        // The last entry refers to the sink.
+        ofs << ((item + 1u == bucket_stats.size()) ? "sink" : std::to_string(item)) << ","
+            << bucket_stats[item].to_csv() << "\n";
+    }
+}
+
+std::vector<std::size_t> beam_initial_solution(const kplink::Problem& p, std::size_t beam_width, kplink::BeamScore beam_score, double& time_limit) {
+    using namespace kplink;
+    using std::chrono::steady_clock;
+    using std::chrono::duration;
+
+    const auto start_time = steady_clock::now();
+    const auto params = LabellingParams{
+        /* .algo_name = */ "beam",
+        /* .time_limit = */ time_limit,
+        /* .use_completion_bounds = */ true,
+        /* .n_threads = */ 1u,
+        /* .epsilon = */ 0.0,
+        /* .bidirectional = */ false,
+        /* .collect_stats = */ false,
+        /* .selection = */ LabelSelection::ItemOrder,
+        /* .beam_width = */ beam_width,
+        /* .beam_score = */ beam_score,
+        /* .label_budget = */ 0u
+    };
+    auto labelling = Labelling{
+        /* .p = */ p,
+        /* .params = */ params
+    };
+    std::vector<std::size_t> selected_items;
+
+    try {
+        const auto solution = labelling.solve();
+        std::cout << "Info: beam labelling found a solution with profit " << solution.profit
+                  << " in " << solution.time_elapsed << " seconds\n";
+        selected_items = solution.selected_items;
+    } catch(const std::runtime_error& exc) {
+        std::cerr << "Cannot warm-start: " << exc.what() << "\n";
+    }
+
+    // The warm-started solver only gets the time left.
+    time_limit = std::max(time_limit - duration<double>(steady_clock::now() - start_time).count(), 0.0);
+
+    return selected_items;
+}
+
 int main(int argc, char** argv) {
     using namespace kplink;
     using namespace cxxopts;
@@ -44,14 +125,48 @@ int main(int argc, char** argv) {
         ("i,initial",         "Path to solution file which contains an initial solution. "
                               "Must be a csv file with solution under column 'selected_items' or 'primal_selected_items'. "
                               "Only available with algorithms 'bc', 'compact_lp', 'compact_mip'.", value<std::string>())
-        ("a,algorithm",       "Algorithm to use. One of: labelling, compact_mip, compact_lp, bc, greedy, unit_dp. "
-                              "Algorithm unit_dp can only be used with instances with all profits == 1.", value<std::string>())
-        ("v,validineq",       "Use valid inequalities. Available with algorithms 'bc', 'compact_mip', 'compact_lp'.", value<bool>()->default_value("false"))
+        ("a,algorithm",       "Algorithm to use. One of: labelling, compact_mip, compact_lp, bc, greedy, unit_dp, streaming_unit_dp, integer_profit_dp, batch_unit_dp. "
+                              "Algorithms unit_dp, streaming_unit_dp and batch_unit_dp can only be used with instances with all profits == 1. "
+                              "Algorithm integer_profit_dp can only be used with instances whose profits are multiples of a common unit.", value<std::string>())
+        ("v,validineq",       "Use valid inequalities. Available with algorithms 'bc', 'compact_mip', 'compact_lp', "
+                              "and with the fallback of option 'labelbudget'.", value<bool>()->default_value("false"))
         ("f,liftcc",          "Lift compactness constraints. Available with algorithm 'bc', 'compact_mip' and 'compact_lp'.", value<bool>()->default_value("false"))
-        ("t,threads",         "If using a Gurobi-based algorithm, number of threads to use.", value<int>()->default_value("1"))
+        ("t,threads",         "If using a Gurobi-based algorithm, 'labelling' or 'unit_dp', number of threads to use.", value<int>()->default_value("1"))
         ("l,timelimit",       "If using a Gurobi-based algorithm, the time limit in seconds.", value<double>()->default_value("3600"))
         ("s,disablepresolve", "If using a Gurobi-based algorithm, disables presolve. "
                               "Available with algorithm 'compact_mip' because presolve is always off for B&C and LP problems.", value<bool>()->default_value("false"))
+        ("n,nobounds",        "Disables pruning labels with completion bounds. Available with algorithm 'labelling'.", value<bool>()->default_value("false"))
+        ("e,epsilon",         "Relative tolerance for approximate dominance: the solution is within a factor (1 + epsilon) of the certified lower bound. "
+                              "Available with algorithm 'labelling'.", value<double>()->default_value("0"))
+        ("b,bidirectional",   "Grows labels from both ends of the instance and joins them in the middle. "
+                              "Available with algorithm 'labelling'.", value<bool>()->default_value("false"))
+        ("r,selection",       "Order in which labels are extended. One of: item_order, fifo, best_first, depth_first, astar. "
+                              "Strategies other than item_order require a zero epsilon. "
+                              "Available with algorithm 'labelling'.", value<std::string>()->default_value("item_order"))
+        ("k,beamwidth",       "Maximum number of labels kept at each item, turning the labelling into a beam search heuristic. "
+                              "Zero means no limit. Available with algorithm 'labelling'.", value<int>()->default_value("0"))
+        ("beamscore",         "Score used to choose the labels kept by the beam. One of: progress, ratio, completion_bound. "
+                              "Available with algorithm 'labelling' and with option 'warmstart'.", value<std::string>()->default_value("progress"))
+        ("w,warmstart",       "Warm-starts the solver with the solution of a beam search labelling with this beam width. "
+                              "Zero disables it. Available with algorithms 'bc', 'compact_mip', if no initial solution is given.", value<int>()->default_value("0"))
+        ("labelbudget",       "Maximum number of labels created by the labelling. If exceeded, the labelling stops and "
+                              "branch-and-cut solves the instance, starting from its best solution and bounds, within the "
+                              "remaining time. Zero means no limit. Available with algorithm 'labelling'.", value<int>()->default_value("0"))
+        ("stats",             "Saves statistics on the labels of each item next to the results, with suffix '_stats'. "
+                              "Available with algorithm 'labelling'.", value<bool>()->default_value("false"))
+        ("rollinglayers",     "Keeps only O(n sqrt(n)) entries of the DP table, instead of O(n^2), and recomputes part of "
+                              "it to rebuild the solution. Available with algorithm 'unit_dp'.", value<bool>()->default_value("false"))
+        ("frontier",          "Computes the highest weight achievable with each number of items, up to the first number which reaches "
+                              "the weight of option 'frontierweight', saved next to the results with suffix '_frontier', and reads the "
+                              "solution from it. Available with algorithm 'unit_dp'.", value<bool>()->default_value("false"))
+        ("frontierweight",    "Largest minimum weight the frontier must answer. Defaults to the problem's minimum weight, and is "
+                              "never lower than it. Available with option 'frontier'.", value<double>())
+        ("nosimd",            "Disables the vectorised computation of the DP recursion, even if the processor supports it. "
+                              "Available with algorithms 'unit_dp' and 'batch_unit_dp'.", value<bool>()->default_value("false"))
+        ("batch",             "Additional problem files, with the same number of items and maximum distance, solved together with "
+                              "the main one, with one result row each. Available with algorithm 'batch_unit_dp'.", value<std::vector<std::string>>())
+        ("batchwidth",        "Number of problems solved together in the lanes of the vectorised DP. "
+                              "Available with algorithm 'batch_unit_dp'.", value<int>()->default_value("4"))
         ("o,output",          "Save results (in .csv format) in this file. Overwrites previous contents.", value<std::string>())
         ("h,help",            "Prints usage message.");
 
@@ -112,6 +227,47 @@ int main(int argc, char** argv) {
         std::exit(EXIT_FAILURE);
     }
 
+    if(res.count("batchwidth") && (res["batchwidth"].as<int>() < 1 || res["batchwidth"].as<int>() > static_cast<int>(BatchUnitDP::MAX_BATCH_WIDTH))) {
+        std::cerr << "Invalid batch width: " << res["batchwidth"].as<int>() << "\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    if(res.count("epsilon") && res["epsilon"].as<double>() < 0.0) {
+        std::cerr << "Invalid epsilon: " << res["epsilon"].as<double>() << "\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    auto selection = LabelSelection::ItemOrder;
+    try {
+        selection = label_selection_from_string(res["selection"].as<std::string>());
+    } catch(const std::invalid_argument& exc) {
+        std::cerr << exc.what() << "\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    if(selection != LabelSelection::ItemOrder && res["epsilon"].as<double>() > 0.0) {
+        std::cerr << "Selection strategy " << to_string(selection) << " requires a zero epsilon!\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    if(res["beamwidth"].as<int>() < 0 || res["warmstart"].as<int>() < 0) {
+        std::cerr << "Invalid beam width: " << std::min(res["beamwidth"].as<int>(), res["warmstart"].as<int>()) << "\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    if(res["labelbudget"].as<int>() < 0) {
+        std::cerr << "Invalid label budget: " << res["labelbudget"].as<int>() << "\n";
+        std::exit(EXIT_FAILURE);
+    }
+
+    auto beam_score = BeamScore::Progress;
+    try {
+        beam_score = beam_score_from_string(res["beamscore"].as<std::string>());
+    } catch(const std::invalid_argument& exc) {
+        std::cerr << exc.what() << "\n";
+        std::exit(EXIT_FAILURE);
+    }
+
     if(res.count("timelimit") && res["timelimit"].as<double>() < 0.0) {
         std::cerr << "Invalid time limit: " << res["timelimit"].as<double>() << "\n";
         std::exit(EXIT_FAILURE);
@@ -120,7 +276,16 @@ int main(int argc, char** argv) {
     if(algorithm == "labelling") {
         const auto params = LabellingParams{
             /* .algo_name = */ algorithm,
-            /* .time_limit = */ res["timelimit"].as<double>()
+            /* .time_limit = */ res["timelimit"].as<double>(),
+            /* .use_completion_bounds = */ !res["nobounds"].as<bool>(),
+            /* .n_threads = */ static_cast<std::size_t>(res["threads"].as<int>()),
+            /* .epsilon = */ res["epsilon"].as<double>(),
+            /* .bidirectional = */ res["bidirectional"].as<bool>(),
+            /* .collect_stats = */ res["stats"].as<bool>(),
+            /* .selection = */ selection,
+            /* .beam_width = */ static_cast<std::size_t>(res["beamwidth"].as<int>()),
+            /* .beam_score = */ beam_score,
+            /* .label_budget = */ static_cast<std::size_t>(res["labelbudget"].as<int>())
         };
         auto labelling = Labelling{
             /* .p = */ p,
@@ -129,22 +294,152 @@ int main(int argc, char** argv) {
         const auto solution = labelling.solve();
 
         export_solution_to_csv(out, p, params, solution);
+
+        if(params.collect_stats) {
+            export_bucket_stats_to_csv(out.parent_path() / out.stem().concat("_stats.csv"), solution.bucket_stats);
+        }
+
+        if(solution.budget_exceeded) {
+            std::cout << "Info: the labelling exceeded its budget of " << params.label_budget
+                      << " labels, falling back to branch-and-cut\n";
+
+            const auto bc_params = BranchAndCutParams {
+                /* .algo_name = */ "bc_fallback",
+                /* .n_threads = */ res["threads"].as<int>(),
+                /* .time_limit = */ std::max(params.time_limit - solution.time_elapsed, 0.0),
+                /* .use_vi1 = */ res["validineq"].as<bool>(),
+                /* .lift_cc = */ res["liftcc"].as<bool>()
+            };
+            auto solver = BranchAndCut{p, bc_params};
+
+            solver.load_incumbent(solution.selected_items, solution.lower_bound);
+
+            const auto bc_solution = solver.solve();
+
+            export_solution_to_csv(out.parent_path() / out.stem().concat("_fallback.csv"), p, bc_params, bc_solution);
+        }
     } else if (algorithm == "unit_dp") {
         const auto params = UnitDPParams{
-            /* .algo_name = */ algorithm
+            /* .algo_name = */ algorithm,
+            /* .rolling_layers = */ res["rollinglayers"].as<bool>(),
+            /* .n_threads = */ static_cast<std::size_t>(res["threads"].as<int>()),
+            /* .use_simd = */ !res["nosimd"].as<bool>()
         };
         auto unit_dp = UnitDP{
             /* .p = */ p,
             /* .params = */ params
         };
-        const auto solution = unit_dp.solve();
+
+        if(!res["frontier"].as<bool>()) {
+            const auto solution = unit_dp.solve();
+
+            export_solution_to_csv(out, p, params, solution);
+        } else {
+            const auto max_weight = res.count("frontierweight") ?
+                std::max(res["frontierweight"].as<double>(), p.min_weight) : p.min_weight;
+            const auto frontier = unit_dp.solve_frontier(max_weight);
+            const auto frontier_out = out.parent_path() / out.stem().concat("_frontier.csv");
+            std::ofstream ofs{frontier_out};
+
+            if(ofs.fail()) {
+                std::cerr << "Cannot write frontier to " << frontier_out << ": skipping!\n";
+            } else {
+                ofs << UnitDPFrontier::csv_header << "\n";
+
+                for(const auto& point : frontier.points) {
+                    ofs << UnitDPFrontier::to_csv(point, unit_dp.frontier_items(point)) << "\n";
+                }
+            }
+
+            const auto solution = unit_dp.solve_from_frontier(frontier, p.min_weight);
+
+            export_solution_to_csv(out, p, params, solution);
+        }
+    } else if(algorithm == "streaming_unit_dp") {
+        if(std::any_of(p.profits.begin(), p.profits.end(), [] (double profit) { return profit != 1.0; })) {
+            std::cerr << "Algorithm streaming_unit_dp can only be used with instances with all profits == 1!\n";
+            std::exit(EXIT_FAILURE);
+        }
+
+        const auto params = StreamingUnitDPParams{
+            /* .algo_name = */ algorithm,
+            /* .max_items = */ StreamingUnitDP::greedy_max_items(p)
+        };
+        auto streaming_dp = StreamingUnitDP{
+            /* .min_weight = */ p.min_weight,
+            /* .max_distance = */ p.max_distance,
+            /* .params = */ params
+        };
+        const auto solution = streaming_dp.solve(p.weights);
+
+        export_solution_to_csv(out, p, params, solution);
+    } else if(algorithm == "integer_profit_dp") {
+        if(p.profit_unit <= 0.0) {
+            std::cerr << "Algorithm integer_profit_dp can only be used with instances whose profits are multiples of a common unit!\n";
+            std::exit(EXIT_FAILURE);
+        }
+
+        const auto params = IntegerProfitDPParams{
+            /* .algo_name = */ algorithm
+        };
+        auto integer_dp = IntegerProfitDP{
+            /* .p = */ p,
+            /* .params = */ params
+        };
+        const auto solution = integer_dp.solve();
 
         export_solution_to_csv(out, p, params, solution);
+    } else if(algorithm == "batch_unit_dp") {
+        auto problems = std::vector<Problem>{p};
+
+        if(res.count("batch")) {
+            for(const auto& batch_file : res["batch"].as<std::vector<std::string>>()) {
+                if(!std::filesystem::exists(batch_file)) {
+                    std::cerr << "File not found: " << batch_file << "\n";
+                    std::exit(EXIT_FAILURE);
+                }
+
+                problems.emplace_back(batch_file);
+
+                if(problems.back().n_items != p.n_items || problems.back().max_distance != p.max_distance) {
+                    std::cerr << "Problem " << batch_file << " has a different number of items or maximum distance!\n";
+                    std::exit(EXIT_FAILURE);
+                }
+            }
+        }
+
+        if(std::any_of(problems.begin(), problems.end(), [] (const Problem& problem) {
+            return std::any_of(problem.profits.begin(), problem.profits.end(), [] (double profit) { return profit != 1.0; });
+        })) {
+            std::cerr << "Algorithm batch_unit_dp can only be used with instances with all profits == 1!\n";
+            std::exit(EXIT_FAILURE);
+        }
+
+        const auto params = BatchUnitDPParams{
+            /* .algo_name = */ algorithm,
+            /* .batch_width = */ static_cast<std::size_t>(res["batchwidth"].as<int>()),
+            /* .use_simd = */ !res["nosimd"].as<bool>()
+        };
+        auto batch_dp = BatchUnitDP{
+            /* .problems = */ problems,
+            /* .params = */ params
+        };
+        const auto solutions = batch_dp.solve();
+
+        export_solutions_to_csv(out, problems, params, solutions);
     } else if(algorithm == "compact_mip") {
+        auto time_limit = res["timelimit"].as<double>();
+        std::vector<std::size_t> warm_start;
+
+        if(!initial_sol_file && res["warmstart"].as<int>() > 0) {
+            warm_start = beam_initial_solution(
+                p, static_cast<std::size_t>(res["warmstart"].as<int>()), beam_score, time_limit);
+        }
+
         const auto params = CompactModelParams{
             /* .algo_name = */ algorithm,
             /* .n_threads = */ res["threads"].as<int>(),
-            /* .time_limit = */ res["timelimit"].as<double>(),
+            /* .time_limit = */ time_limit,
             /* .use_vi1 = */ res["validineq"].as<bool>(),
             /* .lift_cc = */ res["liftcc"].as<bool>(),
             /* .use_presolve = */ !res["disablepresolve"].as<bool>()
@@ -155,6 +450,8 @@ int main(int argc, char** argv) {
             solver.load_initial_solution(
                 read_initial_solution(*initial_sol_file)
             );
+        } else if(!warm_start.empty()) {
+            solver.load_initial_solution(warm_start);
         }
 
         const auto solution = solver.solve_integer();
@@ -173,10 +470,18 @@ int main(int argc, char** argv) {
 
         export_solution_to_csv(out, p, params, solution);
     } else if(algorithm == "bc") {
+        auto time_limit = res["timelimit"].as<double>();
+        std::vector<std::size_t> warm_start;
+
+        if(!initial_sol_file && res["warmstart"].as<int>() > 0) {
+            warm_start = beam_initial_solution(
+                p, static_cast<std::size_t>(res["warmstart"].as<int>()), beam_score, time_limit);
+        }
+
         const auto params = BranchAndCutParams {
             /* .algo_name = */ algorithm,
             /* .n_threads = */ res["threads"].as<int>(),
-            /* .time_limit = */ res["timelimit"].as<double>(),
+            /* .time_limit = */ time_limit,
             /* .use_vi1 = */ res["validineq"].as<bool>(),
             /* .lift_cc = */ res["liftcc"].as<bool>()
         };
@@ -186,6 +491,8 @@ int main(int argc, char** argv) {
             solver.load_initial_solution(
                 read_initial_solution(*initial_sol_file)
             );
+        } else if(!warm_start.empty()) {
+            solver.load_initial_solution(warm_start);
         }
 
         const auto solution = solver.solve();